@@ -163,4 +163,63 @@
 		char d_name[MINIX_NAME_MAX]; /**< Name of entry.      */
 	} __attribute__((packed));
 
+/*============================================================================*
+ *                         Hashed Directory Information                       *
+ *============================================================================*/
+
+	/**
+	 * @brief Magic number of a hashed directory index.
+	 */
+	#define DINDEX_MAGIC 0x4448
+	
+	/**
+	 * @brief Directory entry slot where the hashed directory index lives.
+	 */
+	#define DINDEX_SLOT 2
+	
+	/**
+	 * @brief Maximum number of hash buckets in a directory.
+	 */
+	#define DINDEX_MAX 512
+	
+	/*
+	 * Hashed directory index.
+	 * 
+	 * A large directory may have its entries hashed into buckets, so
+	 * that a lookup reads a single block. Bucket i is the (i + 1)-th block
+	 * of the directory, and the first block holds only "." and ".." and
+	 * the index itself. The index looks like a free directory entry, and
+	 * all other entries are plain ones, so a directory may still be read
+	 * linearly by code that does not know about the index.
+	 */
+	struct d_dindex
+	{
+		uint16_t d_ino;       /**< Always INODE_NULL. */
+		uint16_t d_magic;     /**< Magic number.      */
+		uint16_t d_nbuckets;  /**< Number of buckets. */
+		uint8_t d_unused[10]; /**< Unused.            */
+	} __attribute__((packed));
+	
+	/**
+	 * @brief Hashes the name of a directory entry.
+	 * 
+	 * @param name Name of the directory entry.
+	 * 
+	 * @returns The hash value of @p name.
+	 */
+	static inline uint32_t dindex_hash(const char *name)
+	{
+		uint32_t h = 2166136261u;
+		
+		for (int i = 0; i < MINIX_NAME_MAX; i++)
+		{
+			if (name[i] == '\0')
+				break;
+			
+			h = (h ^ (uint8_t)name[i])*16777619u;
+		}
+		
+		return (h ^ (h >> 16));
+	}
+
 #endif /* MINIX_H_ */
@@ -81,6 +81,21 @@
 	 */
 	EXTERN void tlb_flush(void);
 	
+	/*
+	 * Loads the page directory at physical address cr3.
+	 */
+	EXTERN void tlb_load(dword_t cr3);
+	
+	/*
+	 * Flushes the page at addr from the TLB.
+	 */
+	EXTERN void tlb_flush_page(addr_t addr);
+	
+	/*
+	 * Flushes pages in the range [start, end) from the TLB.
+	 */
+	EXTERN void tlb_flush_range(addr_t start, addr_t end);
+	
 	/*
 	 * Flushes the IDT pointed to by idtptr.
 	 */
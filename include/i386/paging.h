@@ -31,6 +31,17 @@
 	#define PGTAB_SIZE (1 << PGTAB_SHIFT) /* Page table size.           */
 	#define PTE_SIZE   4                 /* Page table entry size.     */
 	#define PDE_SIZE   4                 /* Page directory entry size. */
+	
+	/* Largest range that is flushed from the TLB page by page. */
+	#define TLB_FLUSH_MAX 32
+	
+	/* Large (4 MB) and global pages. */
+	#define CPUID_PSE  (1 <<  3) /* Large pages supported?  */
+	#define CPUID_PGE  (1 << 13) /* Global pages supported? */
+	#define CR4_PSE    (1 <<  4) /* Enable large pages.     */
+	#define CR4_PGE    (1 <<  7) /* Enable global pages.    */
+	#define PDE_LARGE  (1 <<  7) /* Maps a large page?      */
+	#define PDE_GLOBAL (1 <<  8) /* Global large page?      */
 
 #ifndef _ASM_FILE_
 
@@ -45,7 +56,8 @@
 		unsigned          :  2; /* Reserved.          */
 		unsigned accessed :  1; /* Accessed?          */
 		unsigned dirty    :  1; /* Dirty?             */
-		unsigned          :  2; /* Reserved.          */
+		unsigned large    :  1; /* Large page?        */
+		unsigned global   :  1; /* Global page?       */
 		unsigned          :  3; /* Unused.            */
 		unsigned frame    : 20; /* Frame number.      */
 	};
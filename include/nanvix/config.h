@@ -41,6 +41,29 @@
 	#define SWAP_DEV          0x0101 /* Swap device number.             */
 	#define NR_FILES             256 /* Number of opened files.         */
 	#define NR_REGIONS           128 /* Number of memory regions.       */
-	#define NR_BUFFERS           256 /* Number of block buffers.        */
+	#define NR_BUFFERS           256 /* Number of low memory buffers.   */
+	#define NR_DENTRIES          256 /* Number of cached name lookups.  */
+	
+	/* Block buffer cache sizing. */
+	#define BUFFERS_POOL_RATIO 25 /* Kernel page pool for buffers (%). */
+	
+	/* Block buffer cache write-back. */
+	#define BUFFERS_DIRTY_RATIO    10 /* Dirty buffers to force write (%). */
+	#define BUFFERS_DIRTY_AGE       5 /* Age to write back (in seconds).   */
+	#define BUFFERS_FLUSH_INTERVAL  1 /* Flusher period (in seconds).      */
+	#define BUFFERS_FLUSH_BATCH    32 /* Buffers written per batch.        */
+	
+	/* Page replacement. */
+	#define PAGES_FREE_LOW   32 /* Free page frames to start paging out. */
+	#define PAGES_FREE_HIGH  64 /* Free page frames to stop paging out.  */
+	#define SWAP_CLUSTER      8 /* Pages written per swap operation.     */
+	#define KSWAPD_INTERVAL   1 /* Page-out daemon period (in seconds).  */
+	
+	/* File read-ahead. */
+	#define READAHEAD_MIN  4 /* Initial read-ahead window (in blocks). */
+	#define READAHEAD_MAX 32 /* Maximum read-ahead window (in blocks). */
+	
+	/* Block preallocation. */
+	#define PREALLOC_MAX 8 /* Preallocation window (in blocks). */
 	
 #endif /* CONFIG_H_ */
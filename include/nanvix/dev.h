@@ -22,6 +22,7 @@
 
 	#include <nanvix/const.h>
 	#include <nanvix/fs.h>
+	#include <sys/iostat.h>
 	#include <sys/types.h>
 
 	/* Device types. */
@@ -131,6 +132,11 @@
 		ssize_t (*write)(dev_t, const char *, size_t, off_t); /* Write.       */
 		int (*readblk)(unsigned, struct buffer *);            /* Read block.  */
 		int (*writeblk)(unsigned, struct buffer *);           /* Write block. */
+		int (*stat)(unsigned, struct iostat *);               /* Statistics.  */
+		int (*flush)(unsigned);                               /* Flush cache. */
+		int (*readblks)(unsigned, buffer_t *, unsigned);      /* Read run.    */
+		int (*writeblks)(unsigned, buffer_t *, unsigned);     /* Write run.   */
+		void *(*map)(unsigned, block_t);                      /* Map block.   */
 	};
 	
 	/*
@@ -192,4 +198,86 @@
 	 */
 	EXTERN void bdev_readblk(struct buffer *buf);
 	
+	/*
+	 * DESCRIPTION:
+	 *   The bdev_writeblks() function writes the n block buffers in the
+	 *   vector pointed to by bufs to the underlying block device. The 
+	 *   buffers shall hold consecutive blocks of the same device, so that
+	 *   the device driver may transfer them in a single command. Each
+	 *   buffer is handled as if it was passed to bdev_writeblk().
+	 * 
+	 * RETURN VALUE:
+	 *   The bdev_writeblks() function has no return value.
+	 * 
+	 * ERRORS:
+	 *   No errors are defined.
+	 */
+	EXTERN void bdev_writeblks(buffer_t *bufs, unsigned n);
+	
+	/*
+	 * DESCRIPTION:
+	 *   The bdev_readblks() function reads the n block buffers in the
+	 *   vector pointed to by bufs from the underlying block device. The 
+	 *   buffers shall hold consecutive blocks of the same device, so that
+	 *   the device driver may transfer them in a single command. Each
+	 *   buffer is handled as if it was passed to bdev_readblk().
+	 * 
+	 * RETURN VALUE:
+	 *   The bdev_readblks() function has no return value.
+	 * 
+	 * ERRORS:
+	 *   No errors are defined.
+	 */
+	EXTERN void bdev_readblks(buffer_t *bufs, unsigned n);
+	
+	/*
+	 * DESCRIPTION:
+	 *   The bdev_map() function returns the address at which the block
+	 *   numbered num of the block device identified by dev lies in kernel
+	 *   memory, if the device is memory-backed. Reading from and writing
+	 *   to this address accesses the block directly. This function never
+	 *   blocks.
+	 * 
+	 * RETURN VALUE:
+	 *   Upon successful completion, the bdev_map() function returns the
+	 *   address of the block. If the device is not memory-backed, a null
+	 *   pointer is returned instead.
+	 * 
+	 * ERRORS:
+	 *   No errors are defined.
+	 */
+	EXTERN void *bdev_map(dev_t dev, block_t num);
+	
+	/*
+	 * DESCRIPTION:
+	 *   The bdev_stat() function gets I/O statistics of the block device 
+	 *   identified by dev, and stores them in the structure pointed to by buf.
+	 * 
+	 * RETURN VALUE:
+	 *   Upon successful completion, the bdev_stat() function returns 0. Upon
+	 *   failure, a negative error code is returned.
+	 * 
+	 * ERRORS:
+	 *   - EINVAL: invalid block device.
+	 */
+	EXTERN int bdev_stat(dev_t dev, struct iostat *buf);
+	
+	/*
+	 * DESCRIPTION:
+	 *   The bdev_flush() function writes the volatile cache of the block
+	 *   device identified by dev to permanent storage. This works as a
+	 *   write barrier: all writes that were submitted to the device before
+	 *   are completed before, and no write submitted after is completed
+	 *   before the cache is flushed. The calling process is blocked until
+	 *   the operation completes.
+	 * 
+	 * RETURN VALUE:
+	 *   Upon successful completion, the bdev_flush() function returns 0. Upon
+	 *   failure, a negative error code is returned.
+	 * 
+	 * ERRORS:
+	 *   - EINVAL: invalid block device.
+	 */
+	EXTERN int bdev_flush(dev_t dev);
+	
 #endif /* DEV_H_ */
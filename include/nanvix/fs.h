@@ -40,6 +40,7 @@
 	#include <nanvix/const.h>
 	#include <nanvix/pm.h>
 	#include <sys/stat.h>
+	#include <sys/iostat.h>
 	#include <sys/types.h>
 	#include <stdint.h>
 	#include <ustat.h>
@@ -65,16 +66,21 @@
 	
 	/* Forward definitions. */
 	EXTERN void bsync(void);
+	EXTERN void bstat(dev_t, struct iostat *);
+	EXTERN void bflushd(void);
 	EXTERN void blklock(buffer_t);
 	EXTERN void blkunlock(buffer_t);
 	EXTERN void brelse(buffer_t);
 	EXTERN buffer_t bread(dev_t, block_t);
+	EXTERN buffer_t bget(dev_t, block_t);
+	EXTERN void breada(dev_t, block_t, unsigned);
 	EXTERN void bwrite(buffer_t);
 	EXTERN void buffer_dirty(buffer_t, int);
 	EXTERN void *buffer_data(const_buffer_t);
 	EXTERN dev_t buffer_dev(const_buffer_t);
 	EXTERN block_t buffer_num(const_buffer_t);
 	EXTERN int buffer_is_sync(const_buffer_t);
+	EXTERN int buffer_is_async(const_buffer_t);
 	
 	/**@}*/
 	
@@ -123,6 +129,8 @@
 		struct inode *hash_next;  /**< Next inode in the hash table.         */
 		struct inode *hash_prev;  /**< Previous inode in the hash table.     */
 		struct process *chain;    /**< Sleeping chain.                       */
+		block_t prealloc;         /**< First preallocated block.             */
+		unsigned nprealloc;       /**< Number of preallocated blocks.        */
 	};
 	
 	/**@}*/
@@ -167,12 +175,23 @@
 	EXTERN void superblock_sync(void);
 	EXTERN block_t block_map(struct inode *, off_t, int);
 	EXTERN void block_free(struct superblock *, block_t, int);
+	EXTERN void block_release(struct inode *);
 	
 	
 /*============================================================================*
  *                              File System Manager                           *
  *============================================================================*/
 
+	/*
+	 * Read-ahead state.
+	 */
+	struct readahead
+	{
+		off_t next;      /* Expected offset of the next read. */
+		off_t ahead;     /* File was read ahead up to here.   */
+		unsigned window; /* Window size (in blocks).          */
+	};
+	
 	/*
 	 * File.
 	 */
@@ -182,6 +201,7 @@
 		int count;           /* Reference count.              */
 		off_t pos;           /* Read/write cursor's position. */
 		struct inode *inode; /* Underlying inode.             */
+		struct readahead ra; /* Read-ahead state.             */
 	};
 	
 	/*
@@ -243,7 +263,8 @@
 	/*
 	 * Reads from a regular file.
 	 */
-	EXTERN ssize_t file_read(struct inode *i, void *buf, size_t n, off_t off);
+	EXTERN ssize_t file_read(struct inode *i, void *buf, size_t n, off_t off,
+	                         struct readahead *ra);
 	
 	/*
 	 * Writes to a regular file.
@@ -74,8 +74,10 @@
 	EXTERN void iowait(void);
 	EXTERN void outputb(word_t, byte_t);
 	EXTERN void outputw(word_t, word_t);
+	EXTERN void outputl(word_t, dword_t);
 	EXTERN byte_t inputb(word_t);
 	EXTERN word_t inputw(word_t);
+	EXTERN dword_t inputl(word_t);
 	/**@}*/	
 
 	/**
@@ -191,6 +191,8 @@
 	/**@{*/
 	EXTERN void* kmemcpy(void *, const void *, size_t);
 	EXTERN void *kmemset(void *, int, size_t);
+	EXTERN void kpage_copy(void *, const void *);
+	EXTERN void kpage_zero(void *);
 	/**@}*/
 	
 	/**
@@ -23,6 +23,7 @@
 	#include <nanvix/const.h>
 	#include <nanvix/hal.h>
 	#include <nanvix/pm.h>
+	#include <sys/mstat.h>
 	#include <sys/types.h>
 	
 	/* Kernel stack size. */
@@ -58,15 +59,25 @@
 	
 	/* Forward definitions. */
 	EXTERN int chkmem(const void *, size_t, mode_t);
-	EXTERN int fubyte(const void *);
-	EXTERN int fudword(const void *);
+	EXTERN int copy_from_user(void *, const void *, size_t);
+	EXTERN int copy_to_user(void *, const void *, size_t);
+	EXTERN ssize_t strncpy_from_user(char *, const char *, size_t);
 	EXTERN int crtpgdir(struct process *);
 	EXTERN int pfault(addr_t);
 	EXTERN int vfault(addr_t);
 	EXTERN void dstrypgdir(struct process *);
+	EXTERN void kswapd(void);
+	EXTERN void purgepg(struct inode *);
 	EXTERN void putkpg(void *);
 	EXTERN void mm_init(void);
 	EXTERN void *getkpg(int);
+	EXTERN void *kmalloc(size_t);
+	EXTERN void kfree(void *);
+	EXTERN void pgstat(struct mstat *);
+	EXTERN void pgusage(struct process *, unsigned *, unsigned *);
+	EXTERN int shrpgdir(struct process *);
+	EXTERN void slabstat(struct mstat *);
+	EXTERN int unshrpgdir(struct process *);
 
 #endif /* _ASM_FILE_ */
 	
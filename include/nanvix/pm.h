@@ -65,8 +65,9 @@
 	 * @name Process flags
 	 */
 	/**@{*/
-	#define PROC_NEW 0 /**< Is the process new?     */
-	#define PROC_SYS 1 /**< Handling a system call? */
+	#define PROC_NEW   0 /**< Is the process new?     */
+	#define PROC_SYS   1 /**< Handling a system call? */
+	#define PROC_VFORK 2 /**< Borrowing address space? */
 	/**@}*/
 	
 	/**
@@ -150,6 +151,9 @@
 		struct pde *pgdir;                 /**< Page directory.         */
 		struct pregion pregs[NR_PREGIONS]; /**< Process memory regions. */
 		size_t size;                       /**< Process size.           */
+		unsigned minflt;                   /**< Minor page faults.      */
+		unsigned majflt;                   /**< Major page faults.      */
+		unsigned cowflt;                   /**< Copy-on-write breaks.   */
 		/**@}*/
 
 		/**
@@ -215,6 +219,7 @@
 	EXTERN void sched(struct process *);
 	EXTERN void sleep(struct process **, int);
 	EXTERN void sndsig(struct process *, int);
+	EXTERN void vfrelease(void);
 	EXTERN void wakeup(struct process **);
 	EXTERN void yield(void);
 	
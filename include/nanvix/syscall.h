@@ -23,6 +23,8 @@
 
 	#include <nanvix/const.h>
 	#include <sys/stat.h>
+	#include <sys/iostat.h>
+	#include <sys/mstat.h>
 	#include <sys/times.h>
 	#include <sys/types.h>
 	#include <sys/utsname.h>
@@ -31,7 +33,7 @@
 	#include <utime.h>
 	
 	/* Number of system calls. */
-	#define NR_SYSCALLS 48
+	#define NR_SYSCALLS 55
 	
 	/* System call numbers. */
 	#define NR_alarm     0
@@ -85,6 +87,10 @@
  	#define NR_semget   48
  	#define NR_semctl   49
  	#define NR_semop    50
+ 	#define NR_iostat   51
+ 	#define NR_mstat    52
+ 	#define NR_vfork    53
+ 	#define NR_waitpid  54
 
 #ifndef _ASM_FILE_
 
@@ -93,6 +99,7 @@
 	EXTERN int sys_brk(void *ptr);
 	EXTERN void sys__exit(int status);
 	EXTERN pid_t sys_fork(void);
+	EXTERN pid_t sys_vfork(void);
 	EXTERN pid_t sys_getpgrp(void);
 	EXTERN pid_t sys_getpid(void);
 	EXTERN pid_t sys_getppid(void);
@@ -106,6 +113,7 @@
 	EXTERN pid_t sys_setpgrp(void);
 	EXTERN int sys_setuid(pid_t uid);
 	EXTERN pid_t sys_wait(int *stat_loc);
+	EXTERN pid_t sys_waitpid(pid_t pid, int *stat_loc, int options);
 	
 	/*
 	 * Duplicates a file descriptor.
@@ -263,6 +271,16 @@
 	 * Get system ticks since initialization
 	 */
 	EXTERN int sys_gticks(void);
+	
+	/*
+	 * Gets block device I/O statistics.
+	 */
+	EXTERN int sys_iostat(dev_t dev, struct iostat *buf);
+	
+	/*
+	 * Gets memory statistics.
+	 */
+	EXTERN int sys_mstat(struct mstat *buf);
 
 #endif /* _ASM_FILE_ */
 
@@ -62,10 +62,20 @@
 
 	/* Types. */
 	typedef void (*sighandler_t)(int);
+	typedef unsigned sigset_t;
 	
 	/* Function prototypes. */
 	extern sighandler_t signal(int sig, sighandler_t func);
 	extern int kill(pid_t pid, int sig);
+	
+	/*
+	 * Manipulates signal sets.
+	 */
+	extern int sigemptyset(sigset_t *set);
+	extern int sigfillset(sigset_t *set);
+	extern int sigaddset(sigset_t *set, int sig);
+	extern int sigdelset(sigset_t *set, int sig);
+	extern int sigismember(const sigset_t *set, int sig);
 
 #endif /* _ASM_FILE_ */
 
@@ -0,0 +1,113 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPAWN_H_
+#define SPAWN_H_
+#ifndef _ASM_FILE_
+
+	#include <sys/types.h>
+	#include <signal.h>
+
+	/* Maximum number of file actions. */
+	#define SPAWN_ACTIONS_MAX 8
+
+	/* File action types. */
+	#define SPAWN_CLOSE 0 /* close().  */
+	#define SPAWN_DUP2  1 /* dup2().   */
+	#define SPAWN_OPEN  2 /* open().   */
+
+	/* Flags for posix_spawnattr_setflags(). */
+	#define POSIX_SPAWN_SETPGROUP 001 /* Create a new process group. */
+	#define POSIX_SPAWN_SETSIGDEF 002 /* Reset signals to default.   */
+
+	/*
+	 * File action.
+	 */
+	struct spawn_action
+	{
+		int type;         /* Action type.           */
+		int fd;           /* File descriptor.       */
+		int newfd;        /* Target descriptor.     */
+		const char *path; /* Path name for open().  */
+		int oflag;        /* Open flags.            */
+		mode_t mode;      /* Creation mode.         */
+	};
+
+	/*
+	 * File actions.
+	 */
+	typedef struct
+	{
+		int nactions;                                   /* Count.   */
+		struct spawn_action actions[SPAWN_ACTIONS_MAX]; /* Actions. */
+	} posix_spawn_file_actions_t;
+
+	/*
+	 * Spawn attributes.
+	 */
+	typedef struct
+	{
+		short flags;         /* Flags.                    */
+		pid_t pgroup;        /* Process group.            */
+		sigset_t sigdefault; /* Signals reset to default. */
+	} posix_spawnattr_t;
+
+	/*
+	 * Spawns a process.
+	 */
+	extern int posix_spawn(pid_t *pid, const char *path,
+		const posix_spawn_file_actions_t *file_actions,
+		const posix_spawnattr_t *attrp, char *const argv[],
+		char *const envp[]);
+
+	/*
+	 * Spawns a process, searching for the executable in PATH.
+	 */
+	extern int posix_spawnp(pid_t *pid, const char *file,
+		const posix_spawn_file_actions_t *file_actions,
+		const posix_spawnattr_t *attrp, char *const argv[],
+		char *const envp[]);
+
+	/*
+	 * Manipulates file actions.
+	 */
+	extern int posix_spawn_file_actions_init
+		(posix_spawn_file_actions_t *file_actions);
+	extern int posix_spawn_file_actions_destroy
+		(posix_spawn_file_actions_t *file_actions);
+	extern int posix_spawn_file_actions_addclose
+		(posix_spawn_file_actions_t *file_actions, int fd);
+	extern int posix_spawn_file_actions_adddup2
+		(posix_spawn_file_actions_t *file_actions, int fd, int newfd);
+	extern int posix_spawn_file_actions_addopen
+		(posix_spawn_file_actions_t *file_actions, int fd, const char *path,
+		int oflag, mode_t mode);
+
+	/*
+	 * Manipulates spawn attributes.
+	 */
+	extern int posix_spawnattr_init(posix_spawnattr_t *attr);
+	extern int posix_spawnattr_destroy(posix_spawnattr_t *attr);
+	extern int posix_spawnattr_setflags(posix_spawnattr_t *attr, short flags);
+	extern int posix_spawnattr_setpgroup(posix_spawnattr_t *attr, pid_t pgroup);
+	extern int posix_spawnattr_setsigdefault
+		(posix_spawnattr_t *attr, const sigset_t *sigdefault);
+
+#endif /* _ASM_FILE_ */
+#endif /* SPAWN_H_ */
@@ -0,0 +1,46 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IOSTAT_H_
+#define IOSTAT_H_
+#ifndef _ASM_FILE_
+
+	#include <sys/types.h>
+
+	/*
+	 * Block device I/O statistics.
+	 */
+	struct iostat
+	{
+		unsigned io_requests; /* Requests submitted to the device. */
+		unsigned io_merged;   /* Requests merged into others.      */
+		unsigned io_commands; /* Commands issued to the device.    */
+		unsigned io_seeks;    /* Non-sequential commands.          */
+		unsigned io_avoided;  /* Seeks avoided by reordering.      */
+		unsigned io_hits;     /* Block buffer cache hits.          */
+		unsigned io_misses;   /* Block buffer cache misses.        */
+	};
+	
+	/*
+	 * Gets block device I/O statistics.
+	 */
+	extern int iostat(dev_t dev, struct iostat *buf);
+
+#endif /* _ASM_FILE_ */
+#endif /* IOSTAT_H_ */
@@ -0,0 +1,46 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MSTAT_H_
+#define MSTAT_H_
+#ifndef _ASM_FILE_
+
+	/*
+	 * Memory statistics.
+	 */
+	struct mstat
+	{
+		unsigned ms_kpages;      /* Kernel pages in the pool.       */
+		unsigned ms_kpages_used; /* Kernel pages in use.            */
+		unsigned ms_kpages_peak; /* Peak kernel pages in use.       */
+		unsigned ms_kpages_fail; /* Failed kernel page allocations. */
+		unsigned ms_slabs;       /* Kernel pages used by slabs.     */
+		unsigned ms_objects;     /* Small kernel objects in use.    */
+		unsigned ms_frames;      /* User page frames.               */
+		unsigned ms_frames_free; /* Free user page frames.          */
+		unsigned ms_shared_out;  /* Shared page frames paged out.   */
+	};
+	
+	/*
+	 * Gets memory statistics.
+	 */
+	extern int mstat(struct mstat *buf);
+
+#endif /* _ASM_FILE_ */
+#endif /* MSTAT_H_ */
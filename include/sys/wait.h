@@ -25,9 +25,19 @@
 	#define _NEED_WSTATUS
 	#include <decl.h>
     
+	/**
+	 * @brief Do not hang if no status is available.
+	 */
+	#define WNOHANG 1
+	
     /*
 	 * Waits for a child process to stop or terminate.
 	 */
 	extern pid_t wait(int *stat_loc);
+	
+	/*
+	 * Waits for a specific child process to stop or terminate.
+	 */
+	extern pid_t waitpid(pid_t pid, int *stat_loc, int options);
 
 #endif /* WAIT_H_ */
@@ -108,6 +108,11 @@
 	 * Creates a new process.
 	 */
 	extern pid_t fork(void);
+	
+	/*
+	 * Creates a new process that borrows the address space of the caller.
+	 */
+	extern pid_t vfork(void);
 
 	/*
 	 * Gets the pathname of the current working directory.
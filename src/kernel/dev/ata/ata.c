@@ -57,6 +57,7 @@
 #define ATA_REG_CMD     7 /* Command register.          */
 #define ATA_REG_STATUS  7 /* Status register.           */
 #define ATA_REG_ASTATUS 8 /* Alternate status register. */
+#define ATA_REG_CONTROL 8 /* Control register.          */
 
 /* ATA status register. */
 #define ATA_ERR   (1 << 0) /* Device error. */
@@ -72,9 +73,14 @@
 #define ATA_CMD_READ_SECTORS_EXT	0x24 /* Read sectors using LBA 48-bit.  */
 #define ATA_CMD_WRITE_SECTORS		0x30 /* Write sectors using LBA 28-bit. */
 #define ATA_CMD_WRITE_SECTORS_EXT	0x34 /* Write sectors using LBA 48-bit. */
+#define ATA_CMD_READ_DMA_EXT		0x25 /* Read DMA using LBA 48-bit.      */
+#define ATA_CMD_WRITE_DMA_EXT		0x35 /* Write DMA using LBA 48-bit.     */
 #define ATA_CMD_FLUSH_CACHE			0xe7 /* Flush cache using LBA 28-bit.   */
 #define ATA_CMD_FLUSH_CACHE_EXT		0xeA /* Flush cache using LBA 48-bit.   */
 	
+/* ATA control register. */
+#define ATA_NIEN (1 << 1) /* Disable interrupts. */
+
 /* ATA device information. */
 #define ATA_INFO_WORDS            256 /* # words returned by identify cmd. */
 #define ATA_INFO_CONFIG             0 /* Configuration.                    */
@@ -170,36 +176,91 @@ struct ata_info
 /* ATA device maximum queue size. */
 #define ATADEV_QUEUE_SIZE 64
 
+/* Maximum number of blocks in a merged request. */
+#define ATA_MERGE_MAX 16
+
 /* ATA device flags. */
-#define ATADEV_VALID   (1 << 0) /* Valid device?     */
-#define ATADEV_DISCARD (1 << 1) /* Discard next IRQ? */
+#define ATADEV_VALID   (1 << 0) /* Valid device?       */
+#define ATADEV_DISCARD (1 << 1) /* Discard next IRQ?   */
+#define ATADEV_BMDMA   (1 << 2) /* Use bus master DMA? */
 
 /* Request flags. */
 #define REQ_WRITE (1 << 0) /* Write request?         */
 #define REQ_BUF   (1 << 1) /* Buffered request?      */
 #define REQ_SYNC  (1 << 2) /* Synchronous operation? */
+#define REQ_DMA   (1 << 3) /* Served with DMA?       */
+#define REQ_FLUSH (1 << 4) /* Cache flush (barrier)? */
+
+/* PCI configuration space. */
+#define PCI_CONFIG_ADDRESS 0xcf8 /* Configuration address port. */
+#define PCI_CONFIG_DATA    0xcfc /* Configuration data port.    */
+
+/* PCI configuration registers. */
+#define PCI_REG_ID      0x00 /* Vendor and device ID.         */
+#define PCI_REG_COMMAND 0x04 /* Command register.             */
+#define PCI_REG_CLASS   0x08 /* Class, subclass and prog. if. */
+#define PCI_REG_BAR4    0x20 /* Base address register 4.      */
+
+/* PCI command register. */
+#define PCI_COMMAND_IO     (1 << 0) /* I/O space enable.  */
+#define PCI_COMMAND_MASTER (1 << 2) /* Bus master enable. */
+
+/* PCI IDE controller. */
+#define PCI_CLASS_IDE     0x0101   /* Mass storage, IDE.  */
+#define PCI_PROGIF_MASTER (1 << 7) /* Bus master capable? */
+
+/* Bus master IDE registers. */
+#define BMIDE_REG_CMD    0 /* Command register.           */
+#define BMIDE_REG_STATUS 2 /* Status register.            */
+#define BMIDE_REG_PRDT   4 /* PRD table address register. */
+
+/* Bus master IDE command register. */
+#define BMIDE_CMD_START (1 << 0) /* Start transfer.                 */
+#define BMIDE_CMD_READ  (1 << 3) /* Transfer from device to memory. */
+
+/* Bus master IDE status register. */
+#define BMIDE_STATUS_ERR (1 << 1) /* Transfer error. */
+#define BMIDE_STATUS_IRQ (1 << 2) /* IRQ raised.     */
+
+/* End of PRD table. */
+#define PRD_EOT 0x8000
+
+/*
+ * Physical region descriptor.
+ */
+struct prd
+{
+	uint32_t addr;  /* Physical address.         */
+	uint16_t size;  /* Byte count (0 means 64K). */
+	uint16_t flags; /* Flags.                    */
+} __attribute__((packed));
 
 /*
  * I/O operation request.
  */
 struct request
 {
-	unsigned flags; /* Flags (see above). */
+	unsigned flags;       /* Flags (see above).         */
+	unsigned seq;         /* Arrival order.             */
+	block_t num;          /* First block number.        */
+	size_t size;          /* Transfer size (in bytes).  */
+	struct request *next; /* Next request in the queue. */
 	
 	union
 	{
 		/* Raw request. */
 		struct
 		{
-			block_t num;        /* Block number. */
-			size_t size;        /* Buffer size.  */
-			unsigned char *buf; /* Buffer.       */
+			unsigned char *buf; /* Buffer.             */
+			int *done;          /* Completion counter. */
 		} raw;
 		
 		/* Buffered request. */
 		struct
 		{
-			buffer_t buf; /* Underlying buffer. */
+			int nbufs;                    /* Number of buffers.  */
+			buffer_t bufs[ATA_MERGE_MAX]; /* Underlying buffers. */
+			int *done[ATA_MERGE_MAX];     /* Completion flags.   */
 		} buffered;
 	} u;
 };
@@ -218,12 +279,18 @@ PRIVATE struct atadev
 	struct
 	{
 		int size;                                   /* Current size.         */
-		int head;                                   /* Head.                 */
-		int tail;                                   /* Tail.                 */
+		unsigned seq;                               /* Next arrival number.  */
+		block_t head;                               /* Disk head position.   */
+		struct request *curr;                       /* Request in service.   */
+		struct request *pending;                    /* Sorted by block.      */
+		struct request *free;                       /* Free requests.        */
 		struct request requests[ATADEV_QUEUE_SIZE]; /* Blocks.               */
 		struct process *chain;                      /* Processes wanting for *
 		                                             * a slot in the queue.  */
 	} queue;
+	
+	/* I/O statistics. */
+	struct iostat stats;
 } ata_devices[4];
 
 /*
@@ -236,6 +303,18 @@ PRIVATE uint16_t pio_ports[2][9] = {
 	{ 0x170, 0x171, 0x172, 0x173, 0x174, 0x175, 0x176, 0x177, 0x376 }
 };
 
+/*
+ * Bus master IDE I/O ports (zero if not available).
+ */
+PRIVATE uint16_t bmide_ports[2] = { 0, 0 };
+
+/*
+ * PRD tables. Each table is aligned to its size,
+ * so that it never crosses a 64 KB boundary.
+ */
+PRIVATE struct prd prdt[2][ATA_MERGE_MAX]
+	__attribute__((aligned(ATA_MERGE_MAX*sizeof(struct prd))));
+
 /*============================================================================*
  *                            Low-Level Routines                              *
  *============================================================================*/
@@ -293,10 +372,78 @@ PRIVATE void ata_device_select(int atadevid)
  */
 PRIVATE void ata_bus_wait(int bus)
 {
-	while (inputb(pio_ports[bus][ATA_REG_ASTATUS] & ATA_BUSY))
+	while (inputb(pio_ports[bus][ATA_REG_ASTATUS]) & ATA_BUSY)
 		/* noop*/ ;
 }
 
+/*
+ * Reads a register from the PCI configuration space.
+ */
+PRIVATE dword_t pci_read(int slot, int func, int reg)
+{
+	outputl(PCI_CONFIG_ADDRESS,
+		0x80000000 | (slot << 11) | (func << 8) | (reg & 0xfc));
+	
+	return (inputl(PCI_CONFIG_DATA));
+}
+
+/*
+ * Writes a register to the PCI configuration space.
+ */
+PRIVATE void pci_write(int slot, int func, int reg, dword_t val)
+{
+	outputl(PCI_CONFIG_ADDRESS,
+		0x80000000 | (slot << 11) | (func << 8) | (reg & 0xfc));
+	outputl(PCI_CONFIG_DATA, val);
+}
+
+/*
+ * Probes the first PCI bus for a bus master IDE controller.
+ */
+PRIVATE int bmide_probe(void)
+{
+	int slot;        /* PCI slot.         */
+	int func;        /* PCI function.     */
+	dword_t class;   /* Device class.     */
+	dword_t bar;     /* Base address.     */
+	dword_t command; /* Command register. */
+	
+	for (slot = 0; slot < 32; slot++)
+	{
+		for (func = 0; func < 8; func++)
+		{
+			/* No device. */
+			if ((pci_read(slot, func, PCI_REG_ID) & 0xffff) == 0xffff)
+				continue;
+			
+			class = pci_read(slot, func, PCI_REG_CLASS);
+			
+			/* Not a bus master IDE controller. */
+			if ((class >> 16) != PCI_CLASS_IDE)
+				continue;
+			if (!((class >> 8) & PCI_PROGIF_MASTER))
+				continue;
+			
+			/* Bus master registers are not in I/O space. */
+			bar = pci_read(slot, func, PCI_REG_BAR4);
+			if (!(bar & 1))
+				continue;
+			
+			/* Enable bus mastering. */
+			command = pci_read(slot, func, PCI_REG_COMMAND) & 0xffff;
+			command |= PCI_COMMAND_IO | PCI_COMMAND_MASTER;
+			pci_write(slot, func, PCI_REG_COMMAND, command);
+			
+			bmide_ports[ATA_BUS_PRIMARY] = bar & 0xfffc;
+			bmide_ports[ATA_BUS_SECONDARY] = (bar & 0xfffc) + 8;
+			
+			return (0);
+		}
+	}
+	
+	return (-1);
+}
+
 /*
  * Sets up PATA device.
  */
@@ -352,12 +499,21 @@ PRIVATE int pata_setup(int atadevid)
 		devinfo->flags |= ATADEV_DMA;
 	
 	dev->flags = ATADEV_VALID | ATADEV_DISCARD;
-	dev->queue.chain = NULL;
 	dev->queue.size = 0;
+	dev->queue.seq = 0;
 	dev->queue.head = 0;
-	dev->queue.tail = 0;
+	dev->queue.curr = NULL;
+	dev->queue.pending = NULL;
 	dev->queue.chain = NULL;
 	
+	/* Build list of free requests. */
+	dev->queue.free = NULL;
+	for (i = ATADEV_QUEUE_SIZE - 1; i >= 0; i--)
+	{
+		dev->queue.requests[i].next = dev->queue.free;
+		dev->queue.free = &dev->queue.requests[i];
+	}
+	
 	return (0);
 }
 
@@ -417,32 +573,48 @@ PRIVATE int ata_identify(int atadevid)
 }
 
 /*
- * Issues a read operation.
+ * Reads data from the data register of an ATA bus.
  */
-PRIVATE void ata_read_op(unsigned atadevid, struct request *req)
+PRIVATE void ata_pio_in(int bus, unsigned char *buf, size_t size)
 {
-	int bus;       /* Bus number.        */
-	byte_t byte;   /* Byte used for I/O. */
-	uint64_t addr; /* Read address.      */
-	size_t size;    /* # bytes to read.   */
+	size_t i;    /* Loop index.        */
+	word_t word; /* Word used for I/O. */
 	
-	ata_device_select(atadevid);
-	bus = ata_bus(atadevid);
-
-	/* Buffered read. */
-	if (req->flags & REQ_BUF)
+	for (i = 0; i < size; i += 2)
 	{
-		size = BLOCK_SIZE;
-		addr = buffer_num(req->u.buffered.buf) << 
-			(BLOCK_SIZE_LOG2 - ATA_SECTOR_SIZE_LOG2);
+		ata_bus_wait(bus);
+		word = inputw(pio_ports[bus][ATA_REG_DATA]);
+		buf[i] = word & 0xff;
+		buf[i + 1] = (word >> 8) & 0xff;
 	}
+}
+
+/*
+ * Writes data to the data register of an ATA bus.
+ */
+PRIVATE void ata_pio_out(int bus, const unsigned char *buf, size_t size)
+{
+	size_t i;    /* Loop index.        */
+	word_t word; /* Word used for I/O. */
 	
-	/* Raw read. */
-	else
+	for (i = 0; i < size; i += 2)
 	{
-		size = req->u.raw.size;
-		addr = req->u.raw.num << (BLOCK_SIZE_LOG2 - ATA_SECTOR_SIZE_LOG2);
+		ata_bus_wait(bus);
+		word = buf[i];
+		word |= buf[i + 1] << 8;
+		outputw(pio_ports[bus][ATA_REG_DATA], word);
+		iowait();
 	}
+}
+
+/*
+ * Sends the LBA 48-bit address and sector count of a request.
+ */
+PRIVATE void ata_setup_op(int bus, struct request *req)
+{
+	uint64_t addr; /* LBA 48-bit address. */
+	
+	addr = (uint64_t)req->num << (BLOCK_SIZE_LOG2 - ATA_SECTOR_SIZE_LOG2);
 
 	/*
 	 * Set LBA bit, to specify
@@ -457,11 +629,78 @@ PRIVATE void ata_read_op(unsigned atadevid, struct request *req)
 	outputb(pio_ports[bus][ATA_REG_LBAH], (addr >> 0x28) & 0xff);
 
 	/* Send the three lowest bytes of the address. */
-	outputb(pio_ports[bus][ATA_REG_NSECT], size/ATA_SECTOR_SIZE);
+	outputb(pio_ports[bus][ATA_REG_NSECT], req->size/ATA_SECTOR_SIZE);
 	outputb(pio_ports[bus][ATA_REG_LBAL], (addr >> 0x00) & 0xff);
 	outputb(pio_ports[bus][ATA_REG_LBAM], (addr >> 0x08) & 0xff);
 	outputb(pio_ports[bus][ATA_REG_LBAH], (addr >> 0x10) & 0xff);
+}
+
+/*
+ * Builds the PRD table of a request and programs the bus master.
+ */
+PRIVATE int ata_dma_setup(int bus, struct request *req)
+{
+	int i;           /* Loop index.        */
+	int n;           /* Number of regions. */
+	addr_t addr;     /* Region address.    */
+	struct prd *prd; /* PRD table.         */
+	
+	prd = prdt[bus];
+	n = req->size >> BLOCK_SIZE_LOG2;
+	
+	/* One region per block. */
+	for (i = 0; i < n; i++)
+	{
+		addr = (req->flags & REQ_BUF) ?
+			ADDR(buffer_data(req->u.buffered.bufs[i])) :
+			ADDR(req->u.raw.buf) + i*BLOCK_SIZE;
+		
+		/*
+		 * The bus master can only reach memory that is
+		 * identity mapped in kernel space. Regions that are
+		 * aligned to the block size never cross a 64 KB
+		 * boundary.
+		 */
+		if ((addr < KBASE_VIRT) || (addr & (BLOCK_SIZE - 1)))
+			return (-1);
+		
+		prd[i].addr = addr - KBASE_VIRT;
+		prd[i].size = BLOCK_SIZE;
+		prd[i].flags = 0;
+	}
+	prd[n - 1].flags = PRD_EOT;
+	
+	outputl(bmide_ports[bus] + BMIDE_REG_PRDT, ADDR(prd) - KBASE_VIRT);
+	outputb(bmide_ports[bus] + BMIDE_REG_CMD,
+		(req->flags & REQ_WRITE) ? 0 : BMIDE_CMD_READ);
+	outputb(bmide_ports[bus] + BMIDE_REG_STATUS,
+		BMIDE_STATUS_ERR | BMIDE_STATUS_IRQ);
+	
+	return (0);
+}
+
+/*
+ * Issues a read operation.
+ */
+PRIVATE void ata_read_op(unsigned atadevid, struct request *req)
+{
+	int bus;     /* Bus number.        */
+	byte_t byte; /* Byte used for I/O. */
+	
+	ata_device_select(atadevid);
+	bus = ata_bus(atadevid);
 
+	ata_setup_op(bus, req);
+	
+	/* DMA transfer. */
+	if (req->flags & REQ_DMA)
+	{
+		outputb(pio_ports[bus][ATA_REG_CMD], ATA_CMD_READ_DMA_EXT);
+		outputb(bmide_ports[bus] + BMIDE_REG_CMD,
+			BMIDE_CMD_READ | BMIDE_CMD_START);
+		return;
+	}
+	
 	outputb(pio_ports[bus][ATA_REG_CMD], ATA_CMD_READ_SECTORS_EXT);
 	ata_bus_wait(bus);
 
@@ -476,52 +715,24 @@ PRIVATE void ata_read_op(unsigned atadevid, struct request *req)
  */
 PRIVATE void ata_write_op(unsigned atadevid, struct request *req)
 {
-	int bus;            /* Bus number.         */
-	size_t i;           /* Loop index.         */
-	size_t size;        /* Write size.         */
-	byte_t byte;        /* Byte used for I/O.  */
-	uint64_t addr;      /* LBA 48-bit address. */
-	word_t word;        /* Word used for I/O.  */
-	unsigned char *buf; /* Buffer to use.      */
+	int i;              /* Loop index.        */
+	int bus;            /* Bus number.        */
+	byte_t byte;        /* Byte used for I/O. */
+	unsigned char *buf; /* Buffer to use.     */
 	
 	ata_device_select(atadevid);
 	bus = ata_bus(atadevid);
 
-	/* Buffered I/O write. */
-	if (req->flags & REQ_BUF)
-	{
-		buf = buffer_data(req->u.buffered.buf);
-		size = BLOCK_SIZE;
-		addr = buffer_num(req->u.buffered.buf) << 
-			(BLOCK_SIZE_LOG2 - ATA_SECTOR_SIZE_LOG2);
-	}
+	ata_setup_op(bus, req);
 	
-	/* Raw I/O write. */
-	else
+	/* DMA transfer. */
+	if (req->flags & REQ_DMA)
 	{
-		buf = req->u.raw.buf;
-		size = req->u.raw.size;
-		addr = req->u.raw.num << (BLOCK_SIZE_LOG2 - ATA_SECTOR_SIZE_LOG2);
+		outputb(pio_ports[bus][ATA_REG_CMD], ATA_CMD_WRITE_DMA_EXT);
+		outputb(bmide_ports[bus] + BMIDE_REG_CMD, BMIDE_CMD_START);
+		return;
 	}
-
-	/*
-	 * Set LBA bit, to specify
-	 * that the address is in LBA.
-	 */
-	outputb(pio_ports[bus][ATA_REG_DEVCTL], 0x40);
 	
-	/* Send the three highest bytes of the address. */
-	outputb(pio_ports[bus][ATA_REG_NSECT], 0x00);
-	outputb(pio_ports[bus][ATA_REG_LBAL], (addr >> 0x18) & 0xff);
-	outputb(pio_ports[bus][ATA_REG_LBAM], (addr >> 0x20) & 0xff);
-	outputb(pio_ports[bus][ATA_REG_LBAH], (addr >> 0x28) & 0xff);
-
-	/* Send the three lowest bytes of the address. */
-	outputb(pio_ports[bus][ATA_REG_NSECT], size/ATA_SECTOR_SIZE);
-	outputb(pio_ports[bus][ATA_REG_LBAL], (addr >> 0x00) & 0xff);
-	outputb(pio_ports[bus][ATA_REG_LBAM], (addr >> 0x08) & 0xff);
-	outputb(pio_ports[bus][ATA_REG_LBAH], (addr >> 0x10) & 0xff);
-
 	outputb(pio_ports[bus][ATA_REG_CMD], ATA_CMD_WRITE_SECTORS_EXT);
 	ata_bus_wait(bus);
 
@@ -533,108 +744,416 @@ PRIVATE void ata_write_op(unsigned atadevid, struct request *req)
 		return;
 	}			
 		
-	/* Write block. */
-	for (i = 0; i < size; i += 2)
+	/* Buffered I/O write. */
+	if (req->flags & REQ_BUF)
 	{
-		ata_bus_wait(bus);
-		word = buf[i];
-		word |= buf[i + 1] << 8;
-		outputw(pio_ports[bus][ATA_REG_DATA], word);
-		iowait();
+		for (i = 0; i < req->u.buffered.nbufs; i++)
+		{
+			buf = buffer_data(req->u.buffered.bufs[i]);
+			ata_pio_out(bus, buf, BLOCK_SIZE);
+		}
 	}
 	
-	/*
-	 * Flushes ATA cache. Note that this will
-	 * generate a IRQ, which shall be discarded
-	 */
+	/* Raw I/O write. */
+	else
+		ata_pio_out(bus, req->u.raw.buf, req->size);
+}
+
+/*
+ * Issues a cache flush operation.
+ */
+PRIVATE void ata_flush_op(unsigned atadevid)
+{
+	int bus; /* Bus number. */
+	
+	ata_device_select(atadevid);
+	bus = ata_bus(atadevid);
+	
 	outputb(pio_ports[bus][ATA_REG_CMD], ATA_CMD_FLUSH_CACHE_EXT);
-	ata_bus_wait(bus);
-	iowait();
 }
 
 /*
- * Schedules a block disk IO operation.
+ * Completes a DMA transfer.
  */
-PRIVATE void ata_sched(unsigned atadevid, unsigned flags, ...)
+PRIVATE void ata_dma_done(int bus)
 {
-	va_list args;        /* Variable arg list. */
-	struct atadev *dev;  /* ATA device.        */
-	buffer_t buf;        /* Buffer.            */
-	struct request *req; /* Request.           */
+	byte_t status; /* Bus master status. */
+	
+	/* Stop bus master and acknowledge interrupt. */
+	status = inputb(bmide_ports[bus] + BMIDE_REG_STATUS);
+	outputb(bmide_ports[bus] + BMIDE_REG_CMD, 0);
+	outputb(bmide_ports[bus] + BMIDE_REG_STATUS,
+		BMIDE_STATUS_ERR | BMIDE_STATUS_IRQ);
+	
+	if ((status & BMIDE_STATUS_ERR) ||
+		(inputb(pio_ports[bus][ATA_REG_STATUS]) & (ATA_ERR | ATA_DF)))
+		kprintf("ATA: DMA transfer error");
+}
+
+/*
+ * Starts serving a request.
+ */
+PRIVATE void ata_start(unsigned atadevid, struct request *req)
+{
+	struct atadev *dev; /* ATA device. */
 	
 	dev = &ata_devices[atadevid];
+	
+	dev->queue.curr = req;
+	dev->stats.io_commands++;
+	
+	/* Cache flush. */
+	if (req->flags & REQ_FLUSH)
+	{
+		ata_flush_op(atadevid);
+		return;
+	}
+	
+	/* Update statistics. */
+	if (req->num != dev->queue.head)
+		dev->stats.io_seeks++;
+	dev->queue.head = req->num + (req->size >> BLOCK_SIZE_LOG2);
+	
+	/* Use DMA whenever we can, otherwise fall back to PIO. */
+	req->flags &= ~REQ_DMA;
+	if (dev->flags & ATADEV_BMDMA)
+	{
+		if (!ata_dma_setup(ata_bus(atadevid), req))
+			req->flags |= REQ_DMA;
+	}
+	
+	if (req->flags & REQ_WRITE)
+		ata_write_op(atadevid, req);
+	else
+		ata_read_op(atadevid, req);
+}
 
-	disable_interrupts();
+/*
+ * Picks the next request to be served, using the C-LOOK policy.
+ * 
+ * Requests that arrived after a pending cache flush are not
+ * served before it, so that the flush works as a write barrier.
+ */
+PRIVATE struct request *ata_next(struct atadev *dev)
+{
+	struct request *req;     /* Working request.                 */
+	struct request *prev;    /* Previous working request.        */
+	struct request *oldest;  /* Oldest eligible request.         */
+	struct request *barrier; /* Oldest pending barrier.          */
+	struct request *first;   /* First eligible request.          */
+	struct request *fprev;   /* Request before first eligible.   */
+	struct request *next;    /* Chosen request.                  */
+	struct request *nprev;   /* Request before chosen one.       */
+	
+	/* Nothing to be done. */
+	if (dev->queue.pending == NULL)
+		return (NULL);
+	
+	/* Find oldest barrier. */
+	barrier = NULL;
+	for (req = dev->queue.pending; req != NULL; req = req->next)
+	{
+		if (!(req->flags & REQ_FLUSH))
+			continue;
+		
+		if ((barrier == NULL) || ((int)(req->seq - barrier->seq) < 0))
+			barrier = req;
+	}
 	
-		/* Wait for a slot in the block operation queue. */
-		while (dev->queue.size == ATADEV_QUEUE_SIZE)
-			sleep(&dev->queue.chain, PRIO_IO);
+	next = NULL;
+	nprev = NULL;
+	first = NULL;
+	fprev = NULL;
+	oldest = NULL;
+	
+	/*
+	 * Find the first request ahead of the disk
+	 * head. Pending requests are sorted by block
+	 * number, so this is the closest one.
+	 */
+	for (prev = NULL, req = dev->queue.pending; req != NULL; req = req->next)
+	{
+		/* Request must wait for the barrier. */
+		if ((barrier != NULL) && ((int)(req->seq - barrier->seq) >= 0))
+		{
+			prev = req;
+			continue;
+		}
 		
-		req = &dev->queue.requests[dev->queue.tail];
+		if (first == NULL)
+			first = req, fprev = prev;
 		
-		va_start(args, flags);
+		if ((next == NULL) && (req->num >= dev->queue.head))
+			next = req, nprev = prev;
+		
+		if ((oldest == NULL) || ((int)(req->seq - oldest->seq) < 0))
+			oldest = req;
+		
+		prev = req;
+	}
+	
+	/* Serve barrier. */
+	if (first == NULL)
+	{
+		nprev = NULL;
+		for (req = dev->queue.pending; req != barrier; req = req->next)
+			nprev = req;
+		next = barrier;
+	}
+	
+	else
+	{
+		/* Wrap around. */
+		if (next == NULL)
+			next = first, nprev = fprev;
+		
+		/*
+		 * A FIFO queue would have served the oldest
+		 * request. Account for a seek that was avoided.
+		 */
+		if ((next->num == dev->queue.head) && (oldest->num != dev->queue.head))
+			dev->stats.io_avoided++;
+	}
+	
+	/* Remove request from the queue. */
+	if (nprev == NULL)
+		dev->queue.pending = next->next;
+	else
+		nprev->next = next->next;
+	
+	return (next);
+}
+
+/*
+ * Inserts a request in the queue of pending requests.
+ */
+PRIVATE void ata_enqueue(struct atadev *dev, struct request *req)
+{
+	struct request **p; /* Working request. */
+	
+	/* Keep pending requests sorted by block number. */
+	for (p = &dev->queue.pending; *p != NULL; p = &(*p)->next)
+	{
+		if ((*p)->num > req->num)
+			break;
+	}
+	
+	req->next = *p;
+	*p = req;
+}
+
+/*
+ * Merges a buffered request into a pending one.
+ */
+PRIVATE int
+ata_merge(struct atadev *dev, buffer_t buf, unsigned flags, int *done)
+{
+	int i;                   /* Loop index.           */
+	block_t num;             /* Block number.         */
+	struct request *req;     /* Working request.      */
+	struct request *barrier; /* Newest pending barrier. */
+	
+	/* Only buffered requests can be merged. */
+	if (!(flags & REQ_BUF))
+		return (0);
+	
+	num = buffer_num(buf);
+	
+	/* Find newest barrier. */
+	barrier = NULL;
+	for (req = dev->queue.pending; req != NULL; req = req->next)
+	{
+		if (!(req->flags & REQ_FLUSH))
+			continue;
 		
-		/* Buffered I/O operation. */
-		if (flags & REQ_BUF)
+		if ((barrier == NULL) || ((int)(req->seq - barrier->seq) > 0))
+			barrier = req;
+	}
+	
+	for (req = dev->queue.pending; req != NULL; req = req->next)
+	{
+		/* Not compatible. */
+		if (!(req->flags & REQ_BUF))
+			continue;
+		if ((req->flags ^ flags) & REQ_WRITE)
+			continue;
+		if (req->u.buffered.nbufs == ATA_MERGE_MAX)
+			continue;
+		
+		/* Cannot cross a barrier. */
+		if ((barrier != NULL) && ((int)(req->seq - barrier->seq) < 0))
+			continue;
+		
+		/* Back merge. */
+		if (req->num + req->u.buffered.nbufs == num)
 		{
-			buf = va_arg(args, buffer_t);
-			
-			/* Create request. */
-			req->flags = flags;
-			req->u.buffered.buf = buf;
+			i = req->u.buffered.nbufs;
+			goto found;
 		}
 		
-		/* Raw I/O operation. */
-		else
+		/* Front merge. */
+		if (num + 1 == req->num)
 		{
-			/* Create request. */
-			req->flags = flags;
-			req->u.raw.num = va_arg(args, block_t);
-			req->u.raw.buf = va_arg(args, unsigned char *);
-			req->u.raw.size = va_arg(args, size_t);
+			for (i = req->u.buffered.nbufs; i > 0; i--)
+			{
+				req->u.buffered.bufs[i] = req->u.buffered.bufs[i - 1];
+				req->u.buffered.done[i] = req->u.buffered.done[i - 1];
+			}
+			req->num = num;
+			goto found;
 		}
+	}
+	
+	return (0);
+
+found:
+
+	req->u.buffered.bufs[i] = buf;
+	req->u.buffered.done[i] = done;
+	req->u.buffered.nbufs++;
+	req->size += BLOCK_SIZE;
+	dev->stats.io_merged++;
+	
+	return (1);
+}
+
+/*
+ * Schedules a block disk IO operation.
+ */
+PRIVATE void ata_sched(unsigned atadevid, unsigned flags, ...)
+{
+	unsigned i;          /* Loop index.          */
+	int done;            /* Operation completed? */
+	va_list args;        /* Variable arg list.   */
+	struct atadev *dev;  /* ATA device.          */
+	int *pdone;          /* Completion flag.     */
+	buffer_t *bufs;      /* Buffers.             */
+	unsigned nbufs;      /* Number of buffers.   */
+	struct request *req; /* Request.             */
+	
+	dev = &ata_devices[atadevid];
+	done = 0;
+	pdone = (flags & REQ_SYNC) ? &done : NULL;
+
+	disable_interrupts();
+	
+		dev->stats.io_requests++;
 		
-		va_end(args);
+		va_start(args, flags);
 		
-		/* Enqueue request. */
-		dev->queue.tail = (dev->queue.tail + 1)%ATADEV_QUEUE_SIZE;
-		dev->queue.size++;
+		bufs = (flags & REQ_BUF) ? va_arg(args, buffer_t *) : NULL;
+		nbufs = (flags & REQ_BUF) ? va_arg(args, unsigned) : 0;
 		
-		/*
-		 * The queue was empty, therefore,
-		 * we can process this block right now.
+		/* 
+		 * Try to merge a single block with a pending request,
+		 * otherwise wait for a slot in the block operation queue.
 		 */
-		if (dev->queue.size == 1)
+		while ((nbufs != 1) || !ata_merge(dev, bufs[0], flags, pdone))
 		{
-			if (flags & REQ_WRITE)
-				ata_write_op(atadevid, req);
+			/* No slot available. */
+			if (dev->queue.size == ATADEV_QUEUE_SIZE)
+			{
+				sleep(&dev->queue.chain, PRIO_IO);
+				continue;
+			}
+			
+			req = dev->queue.free;
+			dev->queue.free = req->next;
+			dev->queue.size++;
+			
+			/* Create request. */
+			req->flags = flags;
+			req->seq = dev->queue.seq++;
+			req->next = NULL;
+			
+			/* Buffered I/O operation. */
+			if (flags & REQ_BUF)
+			{
+				req->num = buffer_num(bufs[0]);
+				req->size = nbufs*BLOCK_SIZE;
+				req->u.buffered.nbufs = nbufs;
+				for (i = 0; i < nbufs; i++)
+				{
+					req->u.buffered.bufs[i] = bufs[i];
+					req->u.buffered.done[i] = pdone;
+				}
+			}
+			
+			/* Raw I/O operation. */
 			else
-				ata_read_op(atadevid, req);
+			{
+				req->num = va_arg(args, block_t);
+				req->u.raw.buf = va_arg(args, unsigned char *);
+				req->size = va_arg(args, size_t);
+				req->u.raw.done = va_arg(args, int *);
+				if (flags & REQ_SYNC)
+					req->u.raw.done = pdone;
+			}
+			
+			/*
+			 * The device is idle, therefore,
+			 * we can process this block right now.
+			 */
+			if (dev->queue.curr == NULL)
+				ata_start(atadevid, req);
+			else
+				ata_enqueue(dev, req);
+			
+			break;
 		}
 		
+		va_end(args);
+		
 		/* Wait operation to complete. */
-		if (req->flags & REQ_SYNC)
-			sleep(&dev->chain, PRIO_IO);
+		if (flags & REQ_SYNC)
+		{
+			while (!done)
+				sleep(&dev->chain, PRIO_IO);
+		}
 	
 	enable_interrupts();
 }
 
 /*
- * Schedules a buffered I/O operation.
+ * Schedules a buffered I/O operation on consecutive blocks.
+ */
+PRIVATE void ata_sched_buffered(unsigned atadevid, buffer_t *bufs, unsigned n,
+                                unsigned flags)
+{
+	ata_sched(atadevid, flags, bufs, n);
+}
+
+/*
+ * Schedules buffered I/O operations on a run of blocks.
  */
 PRIVATE void
-ata_sched_buffered(unsigned atadevid, buffer_t buf, unsigned flags)
+ata_sched_run(unsigned atadevid, buffer_t *bufs, unsigned n, unsigned flags)
 {
-	ata_sched(atadevid, flags, buf);
+	unsigned i, j; /* Loop indexes. */
+	
+	/* Split the run in as few requests as possible. */
+	for (i = 0; i < n; i += j)
+	{
+		for (j = 1; (i + j < n) && (j < ATA_MERGE_MAX); j++)
+		{
+			if (buffer_num(bufs[i + j]) != buffer_num(bufs[i]) + j)
+				break;
+		}
+		
+		ata_sched_buffered(atadevid, &bufs[i], j, flags);
+	}
 }
 
 /*
  * Schedules a non-buffered I/O operation.
+ * 
+ * Asynchronous operations increment the counter pointed to by done
+ * when they complete.
  */
-PRIVATE void
-ata_sched_raw(unsigned atadevid, block_t num, void *buf, size_t size, unsigned flags)
+PRIVATE void ata_sched_raw(unsigned atadevid, block_t num, void *buf,
+                           size_t size, unsigned flags, int *done)
 {	
-	ata_sched(atadevid, flags, num, buf, size);
+	ata_sched(atadevid, flags, num, buf, size, done);
 }
 
 /*============================================================================*
@@ -646,7 +1165,8 @@ ata_sched_raw(unsigned atadevid, block_t num, void *buf, size_t size, unsigned f
  */
 PRIVATE int ata_readblk(unsigned minor, buffer_t buf)
 {
-	struct atadev *dev;
+	unsigned flags;     /* Request flags. */
+	struct atadev *dev; /* ATA device.    */
 	
 	/* Invalid minor device. */
 	if (minor >= 4)
@@ -658,7 +1178,9 @@ PRIVATE int ata_readblk(unsigned minor, buffer_t buf)
 	if (!(dev->flags & ATADEV_VALID))
 		return (-EINVAL);
 	
-	ata_sched_buffered(minor, buf, REQ_BUF | REQ_SYNC);
+	flags = REQ_BUF | (buffer_is_async(buf) ? 0 : REQ_SYNC);
+	
+	ata_sched_buffered(minor, &buf, 1, flags);
 	
 	return (0);
 }
@@ -683,11 +1205,117 @@ PRIVATE int ata_writeblk(unsigned minor, buffer_t buf)
 	
 	flags = REQ_BUF | REQ_WRITE | (buffer_is_sync(buf) ? REQ_SYNC : 0);
 	
-	ata_sched_buffered(minor, buf, flags);
+	ata_sched_buffered(minor, &buf, 1, flags);
+	
+	return (0);
+}
+
+/*
+ * Reads a run of consecutive blocks from a ATA device.
+ */
+PRIVATE int ata_readblks(unsigned minor, buffer_t *bufs, unsigned n)
+{
+	unsigned flags;     /* Request flags. */
+	struct atadev *dev; /* ATA device.    */
+	
+	/* Invalid minor device. */
+	if (minor >= 4)
+		return (-EINVAL);
+	
+	dev = &ata_devices[minor];
+	
+	/* Device not valid. */
+	if (!(dev->flags & ATADEV_VALID))
+		return (-EINVAL);
+	
+	flags = REQ_BUF | (buffer_is_async(bufs[0]) ? 0 : REQ_SYNC);
+	
+	ata_sched_run(minor, bufs, n, flags);
 	
 	return (0);
 }
 
+/*
+ * Writes a run of consecutive blocks to a ATA device.
+ */
+PRIVATE int ata_writeblks(unsigned minor, buffer_t *bufs, unsigned n)
+{
+	unsigned flags;     /* Request flags. */
+	struct atadev *dev; /* ATA device.    */
+	
+	/* Invalid minor device. */
+	if (minor >= 4)
+		return (-EINVAL);
+	
+	dev = &ata_devices[minor];
+	
+	/* Device not valid. */
+	if (!(dev->flags & ATADEV_VALID))
+		return (-EINVAL);
+	
+	flags = REQ_BUF | REQ_WRITE | (buffer_is_sync(bufs[0]) ? REQ_SYNC : 0);
+	
+	ata_sched_run(minor, bufs, n, flags);
+	
+	return (0);
+}
+
+/*
+ * Transfers bytes between a ATA device and a kernel buffer.
+ * 
+ * Kernel memory is identity mapped, so the buffer is handed to the
+ * device in place. The transfer is split only where a request would
+ * exceed ATA_MERGE_MAX blocks, and all requests are queued before
+ * waiting for them.
+ */
+PRIVATE ssize_t
+ata_kio(unsigned minor, unsigned char *buf, size_t n, off_t off, unsigned flags)
+{
+	size_t i;           /* Loop index.          */
+	int done;           /* Completed requests.  */
+	int nreqs;          /* Issued requests.     */
+	size_t count;       /* # bytes in request.  */
+	block_t blknum;     /* Block number.        */
+	block_t lastblk;    /* Last block.          */
+	struct atadev *dev; /* ATA device.          */
+	
+	dev = &ata_devices[minor];
+	lastblk = (dev->info.nsectors>>(BLOCK_SIZE_LOG2 - ATA_SECTOR_SIZE_LOG2))-1;
+	
+	done = 0;
+	nreqs = 0;
+	for (i = 0; i < n; i += count)
+	{
+		blknum = (off + i) >> BLOCK_SIZE_LOG2;
+		
+		/* End of disk. */
+		if (blknum >= lastblk)
+			break;
+		
+		count = n - i;
+		if (count > ATA_MERGE_MAX*BLOCK_SIZE)
+			count = ATA_MERGE_MAX*BLOCK_SIZE;
+		
+		/* Transfer as much as we can. */
+		if (blknum + (count >> BLOCK_SIZE_LOG2) >= lastblk)
+		{
+			count -= ((blknum + (count >> BLOCK_SIZE_LOG2)) - lastblk) <<
+				BLOCK_SIZE_LOG2;
+		}
+		
+		ata_sched_raw(minor, blknum, &buf[i], count, flags, &done);
+		nreqs++;
+	}
+	
+	/* Wait requests to complete. */
+	disable_interrupts();
+	while (done < nreqs)
+		sleep(&dev->chain, PRIO_IO);
+	enable_interrupts();
+	
+	return ((ssize_t)i);
+}
+
 /*
  * Reads bytes from a ATA device.
  */
@@ -717,6 +1345,10 @@ PRIVATE ssize_t ata_read(unsigned minor, char *buf, size_t n, off_t off)
 	if (n & (BLOCK_SIZE - 1))
 		return (-EINVAL);
 	
+	/* Kernel buffers need no bounce page. */
+	if (ADDR(buf) >= KBASE_VIRT)
+		return (ata_kio(minor, (unsigned char *)buf, n, off, 0));
+	
 	lastblk = (dev->info.nsectors>>(BLOCK_SIZE_LOG2 - ATA_SECTOR_SIZE_LOG2))-1;
 	
 	/* Get a kernel page. */
@@ -747,7 +1379,7 @@ PRIVATE ssize_t ata_read(unsigned minor, char *buf, size_t n, off_t off)
 																BLOCK_SIZE_LOG2;
 		}
 		    
-		ata_sched_raw(minor, blknum, kpg, count, REQ_SYNC);
+		ata_sched_raw(minor, blknum, kpg, count, REQ_SYNC, NULL);
 		kmemcpy(p, kpg, count);
 		
 		p += count;
@@ -793,6 +1425,10 @@ PRIVATE ssize_t ata_write(unsigned minor, const char *buf, size_t n, off_t off)
 	if (n & (BLOCK_SIZE - 1))
 		return (-EINVAL);
 	
+	/* Kernel buffers need no bounce page. */
+	if (ADDR(buf) >= KBASE_VIRT)
+		return (ata_kio(minor, (unsigned char *)buf, n, off, REQ_WRITE));
+	
 	lastblk = (dev->info.nsectors>>(BLOCK_SIZE_LOG2 - ATA_SECTOR_SIZE_LOG2))-1;
 	
 	/* Get a kernel page. */
@@ -824,7 +1460,7 @@ PRIVATE ssize_t ata_write(unsigned minor, const char *buf, size_t n, off_t off)
 		}
 		
 		kmemcpy(kpg, p, count);
-		ata_sched_raw(minor, blknum, kpg, count, REQ_SYNC | REQ_WRITE);
+		ata_sched_raw(minor, blknum, kpg, count, REQ_SYNC | REQ_WRITE, NULL);
 		
 		p += count;
 		i += count;
@@ -839,14 +1475,57 @@ PRIVATE ssize_t ata_write(unsigned minor, const char *buf, size_t n, off_t off)
 	return ((ssize_t)i);
 }
 
+/*
+ * Gets I/O statistics of a ATA device.
+ */
+PRIVATE int ata_stat(unsigned minor, struct iostat *buf)
+{
+	/* Invalid minor device. */
+	if (minor >= 4)
+		return (-EINVAL);
+	
+	/* Device not valid. */
+	if (!(ata_devices[minor].flags & ATADEV_VALID))
+		return (-EINVAL);
+	
+	disable_interrupts();
+	kmemcpy(buf, &ata_devices[minor].stats, sizeof(struct iostat));
+	enable_interrupts();
+	
+	return (0);
+}
+
+/*
+ * Flushes the write cache of a ATA device.
+ */
+PRIVATE int ata_flush(unsigned minor)
+{
+	/* Invalid minor device. */
+	if (minor >= 4)
+		return (-EINVAL);
+	
+	/* Device not valid. */
+	if (!(ata_devices[minor].flags & ATADEV_VALID))
+		return (-EINVAL);
+	
+	ata_sched(minor, REQ_FLUSH | REQ_SYNC, (block_t)0, NULL, (size_t)0, NULL);
+	
+	return (0);
+}
+
 /*
  * ATA device operations.
  */
 PRIVATE const struct bdev ata_ops = {
-	&ata_read,    /* read()     */
-	&ata_write,   /* write()    */
-	&ata_readblk, /* readblk()  */
-	&ata_writeblk /* writeblk() */
+	&ata_read,      /* read()      */
+	&ata_write,     /* write()     */
+	&ata_readblk,   /* readblk()   */
+	&ata_writeblk,  /* writeblk()  */
+	&ata_stat,      /* stat()      */
+	&ata_flush,     /* flush()     */
+	&ata_readblks,  /* readblks()  */
+	&ata_writeblks, /* writeblks() */
+	NULL            /* map()       */
 };
 
 /*
@@ -854,12 +1533,10 @@ PRIVATE const struct bdev ata_ops = {
  */
 PRIVATE void ata_handler(int atadevid)
 {
+	int i;               /* Loop index.    */
 	int bus;             /* Bus number.    */
-	size_t i;            /* Loop index.    */
 	struct atadev *dev;  /* ATA device.    */
 	struct request *req; /* Request.       */
-	word_t word;         /* Working word.  */
-	size_t size;         /* Write size.    */
 	unsigned char *buf;  /* Buffer to use. */
 	
 	bus = ata_bus(atadevid);
@@ -883,29 +1560,28 @@ PRIVATE void ata_handler(int atadevid)
 	}
 	
 	/* Broken block operation queue. */
-	if (dev->queue.size == 0)
+	if (dev->queue.curr == NULL)
 	{
 		kpanic("ATA: broken block operation queue?");
 		goto out;
 	}
 	
-	/* Get first request. */
-	req = &dev->queue.requests[dev->queue.head];
-	dev->queue.head = (dev->queue.head + 1)%ATADEV_QUEUE_SIZE;
-	dev->queue.size--;
+	/* Get request in service. */
+	req = dev->queue.curr;
+	dev->queue.curr = NULL;
 	
-	/* Buffered I/O operation. */
-	if (req->flags & REQ_BUF)
+	/* Cache flush. */
+	if (req->flags & REQ_FLUSH)
 	{
-		buf = buffer_data(req->u.buffered.buf);
-		size = BLOCK_SIZE;
+		inputb(pio_ports[bus][ATA_REG_STATUS]);
+		goto done;
 	}
 	
-	/* Raw I/O operation. */
-	else
+	/* DMA transfer. */
+	if (req->flags & REQ_DMA)
 	{
-		buf = req->u.raw.buf;
-		size = req->u.raw.size;
+		ata_dma_done(bus);
+		goto done;
 	}
 	
 	/* Write operation. */
@@ -917,44 +1593,65 @@ PRIVATE void ata_handler(int atadevid)
 		 */
 		ata_bus_wait(bus);
 		dev->flags &= ~ATADEV_DISCARD;
-			
-		/* Release buffer. */
-		if (req->flags & REQ_BUF)
-		{
-			buffer_dirty(req->u.buffered.buf, 0);
-			brelse(req->u.buffered.buf);
-		}
 	}
 	
 	/* Read operation. */
 	else
 	{			
-		/* Read block. */
-		for (i = 0; i < size; i += 2)
+		/* Buffered read. */
+		if (req->flags & REQ_BUF)
 		{
-			ata_bus_wait(bus);
-			word = inputw(pio_ports[bus][ATA_REG_DATA]);
-			buf[i] = word & 0xff;
-			buf[i + 1] = (word >> 8) & 0xff;
+			for (i = 0; i < req->u.buffered.nbufs; i++)
+			{
+				buf = buffer_data(req->u.buffered.bufs[i]);
+				ata_pio_in(bus, buf, BLOCK_SIZE);
+			}
 		}
+		
+		/* Raw read. */
+		else
+			ata_pio_in(bus, req->u.raw.buf, req->size);
 	}
+
+done:
 	
-	/* Process next operation. */
-	if (dev->queue.size > 0)
+	/* Release buffers and notify waiting processes. */
+	if (req->flags & REQ_BUF)
 	{
-		req = &dev->queue.requests[dev->queue.head];
-		
-		if (req->flags & REQ_WRITE)
-			ata_write_op(atadevid, req);
-		else
-			ata_read_op(atadevid, req);
+		for (i = 0; i < req->u.buffered.nbufs; i++)
+		{
+			/* Written buffers are always released. */
+			if (req->flags & REQ_WRITE)
+			{
+				buffer_dirty(req->u.buffered.bufs[i], 0);
+				brelse(req->u.buffered.bufs[i]);
+			}
+			
+			/* Nobody is waiting for this read. */
+			else if (req->u.buffered.done[i] == NULL)
+				brelse(req->u.buffered.bufs[i]);
+			
+			if (req->u.buffered.done[i] != NULL)
+				*req->u.buffered.done[i] = 1;
+		}
 	}
+	else if (req->u.raw.done != NULL)
+		(*req->u.raw.done)++;
+	
+	/* Release request. */
+	req->next = dev->queue.free;
+	dev->queue.free = req;
+	dev->queue.size--;
+	
+	/* Process next operation. */
+	if ((req = ata_next(dev)) != NULL)
+		ata_start(atadevid, req);
 
 out:
 
 	/*
-	 * Wakeup the process that was waiting for this
-	 * operation and the processes that were waiting
+	 * Wakeup the processes that were waiting for
+	 * an operation and the processes that were waiting
 	 * for an empty slot in the block operation queue.
 	 */
 	wakeup(&dev->queue.chain);
@@ -985,8 +1682,13 @@ PRIVATE void ata2_handler(void)
 PUBLIC void ata_init(void)
 {
 	int i;     /* Loop index.    */
+	int dma;   /* DMA available? */
 	char dvrl; /* Device letter. */
 	
+	dma = !bmide_probe();
+	if (dma)
+		kprintf("ata: bus master IDE at port %x", bmide_ports[0]);
+	
 	/* Detect devices. */
 	for (i = 0, dvrl = 'a'; i < 4; i++, dvrl++)
 	{
@@ -1021,6 +1723,13 @@ PUBLIC void ata_init(void)
 					kprintf("hd%c: PATA HDD detected.", dvrl);
 					kprintf("hd%c: %d sectors.", dvrl, 
 												ata_devices[i].info.nsectors);
+					
+					/* Use DMA transfers. */
+					if (dma && (ata_devices[i].info.flags & ATADEV_DMA))
+					{
+						ata_devices[i].flags |= ATADEV_BMDMA;
+						kprintf("hd%c: DMA enabled.", dvrl);
+					}
 				}
 				break;
 
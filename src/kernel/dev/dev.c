@@ -296,6 +296,112 @@ PUBLIC void bdev_readblk(buffer_t buf)
 		kpanic("failed to read block from device");
 }
 
+/*
+ * Writes a run of consecutive blocks to a block device.
+ */
+PUBLIC void bdev_writeblks(buffer_t *bufs, unsigned n)
+{
+	int err;   /* Error ?        */
+	dev_t dev; /* Device number. */
+	
+	dev = buffer_dev(bufs[0]);
+	
+	/* Invalid device. */
+	if (bdevsw[MAJOR(dev)] == NULL)
+		kpanic("writing blocks to invalid device");
+	
+	/* Write blocks one by one. */
+	if (bdevsw[MAJOR(dev)]->writeblks == NULL)
+	{
+		for (unsigned i = 0; i < n; i++)
+			bdev_writeblk(bufs[i]);
+		return;
+	}
+	
+	/* Write blocks. */
+	err = bdevsw[MAJOR(dev)]->writeblks(MINOR(dev), bufs, n);
+	if (err)
+		kpanic("failed to write blocks to device");
+}
+
+/*
+ * Reads a run of consecutive blocks from a block device.
+ */
+PUBLIC void bdev_readblks(buffer_t *bufs, unsigned n)
+{
+	int err;   /* Error ?        */
+	dev_t dev; /* Device number. */
+	
+	dev = buffer_dev(bufs[0]);
+	
+	/* Invalid device. */
+	if (bdevsw[MAJOR(dev)] == NULL)
+		kpanic("reading blocks from invalid device");
+	
+	/* Read blocks one by one. */
+	if (bdevsw[MAJOR(dev)]->readblks == NULL)
+	{
+		for (unsigned i = 0; i < n; i++)
+			bdev_readblk(bufs[i]);
+		return;
+	}
+	
+	/* Read blocks. */
+	err = bdevsw[MAJOR(dev)]->readblks(MINOR(dev), bufs, n);
+	if (err)
+		kpanic("failed to read blocks from device");
+}
+
+/*
+ * Maps a block of a memory-backed block device.
+ */
+PUBLIC void *bdev_map(dev_t dev, block_t num)
+{
+	/* Invalid device. */
+	if ((MAJOR(dev) >= NR_BLKDEV) || (bdevsw[MAJOR(dev)] == NULL))
+		return (NULL);
+	
+	/* Operation not supported. */
+	if (bdevsw[MAJOR(dev)]->map == NULL)
+		return (NULL);
+	
+	return (bdevsw[MAJOR(dev)]->map(MINOR(dev), num));
+}
+
+/*
+ * Gets I/O statistics of a block device.
+ */
+PUBLIC int bdev_stat(dev_t dev, struct iostat *buf)
+{
+	/* Invalid device. */
+	if ((MAJOR(dev) >= NR_BLKDEV) || (bdevsw[MAJOR(dev)] == NULL))
+		return (-EINVAL);
+	
+	kmemset(buf, 0, sizeof(struct iostat));
+	
+	/* No statistics available. */
+	if (bdevsw[MAJOR(dev)]->stat == NULL)
+		return (0);
+	
+	return (bdevsw[MAJOR(dev)]->stat(MINOR(dev), buf));
+}
+
+/*
+ * Flushes the cache of a block device.
+ */
+PUBLIC int bdev_flush(dev_t dev)
+{
+	/* Invalid device. */
+	if ((MAJOR(dev) >= NR_BLKDEV) || (bdevsw[MAJOR(dev)] == NULL))
+		return (-EINVAL);
+	
+	/* No cache to flush. */
+	if (bdevsw[MAJOR(dev)]->flush == NULL)
+		return (0);
+	
+	return (bdevsw[MAJOR(dev)]->flush(MINOR(dev)));
+}
+
 /*============================================================================*
  *                                 Devices                                    *
  *============================================================================*/
@@ -136,7 +136,13 @@ PRIVATE int ramdisk_readblk(unsigned minor, buffer_t buf)
 	
 	ptr = ramdisks[minor].start + (buffer_num(buf) << BLOCK_SIZE_LOG2);
 	
-	kmemcpy(buffer_data(buf), (void *)ptr, BLOCK_SIZE);
+	/* Buffer is not mapped onto the RAM disk. */
+	if (buffer_data(buf) != (void *)ptr)
+		kmemcpy(buffer_data(buf), (void *)ptr, BLOCK_SIZE);
+	
+	/* Nobody is waiting for this read. */
+	if (buffer_is_async(buf))
+		brelse(buf);
 	
 	return (0);
 }
@@ -150,7 +156,9 @@ PRIVATE int ramdisk_writeblk(unsigned minor, buffer_t buf)
 	
 	ptr = ramdisks[minor].start + (buffer_num(buf) << BLOCK_SIZE_LOG2);
 	
-	kmemcpy((void *)ptr, buffer_data(buf), BLOCK_SIZE);
+	/* Buffer is not mapped onto the RAM disk. */
+	if (buffer_data(buf) != (void *)ptr)
+		kmemcpy((void *)ptr, buffer_data(buf), BLOCK_SIZE);
 	
 	buffer_dirty(buf, 0);
 	brelse(buf);
@@ -158,14 +166,69 @@ PRIVATE int ramdisk_writeblk(unsigned minor, buffer_t buf)
 	return (0);
 }
 
+/*
+ * Reads a run of blocks from a RAM disk device.
+ */
+PRIVATE int ramdisk_readblks(unsigned minor, buffer_t *bufs, unsigned n)
+{
+	/* Invalid device. */
+	if (minor >= NR_RAMDISKS)
+		return (-EINVAL);
+	
+	for (unsigned i = 0; i < n; i++)
+		ramdisk_readblk(minor, bufs[i]);
+	
+	return (0);
+}
+
+/*
+ * Writes a run of blocks to a RAM disk device.
+ */
+PRIVATE int ramdisk_writeblks(unsigned minor, buffer_t *bufs, unsigned n)
+{
+	/* Invalid device. */
+	if (minor >= NR_RAMDISKS)
+		return (-EINVAL);
+	
+	for (unsigned i = 0; i < n; i++)
+		ramdisk_writeblk(minor, bufs[i]);
+	
+	return (0);
+}
+
+/*
+ * Maps a block of a RAM disk device.
+ */
+PRIVATE void *ramdisk_map(unsigned minor, block_t num)
+{
+	addr_t ptr;
+	
+	/* Invalid device. */
+	if (minor >= NR_RAMDISKS)
+		return (NULL);
+	
+	ptr = ramdisks[minor].start + (num << BLOCK_SIZE_LOG2);
+	
+	/* Invalid block. */
+	if (ptr + BLOCK_SIZE > ramdisks[minor].end)
+		return (NULL);
+	
+	return ((void *)ptr);
+}
+
 /*
  * RAM disk device driver interface.
  */
 PRIVATE const struct bdev ramdisk_driver = {
-	&ramdisk_read,     /* read()     */
-	&ramdisk_write,    /* write()    */
-	&ramdisk_readblk,  /* readblk()  */
-	&ramdisk_writeblk  /* writeblk() */
+	&ramdisk_read,      /* read()      */
+	&ramdisk_write,     /* write()     */
+	&ramdisk_readblk,   /* readblk()   */
+	&ramdisk_writeblk,  /* writeblk()  */
+	NULL,               /* stat()      */
+	NULL,               /* flush()     */
+	&ramdisk_readblks,  /* readblks()  */
+	&ramdisk_writeblks, /* writeblks() */
+	&ramdisk_map        /* map()       */
 };
 
 /*
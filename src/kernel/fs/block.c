@@ -30,68 +30,260 @@
  * @brief Superblock module implementation.
  */
 
+/**
+ * @brief Number of zones in a block of the zone map.
+ */
+#define ZMAP_BITS (BLOCK_SIZE << 3)
+
+/**
+ * @brief Gets the word of the zone map where a zone lies.
+ * 
+ * @param sb  Superblock.
+ * @param bit Bit number of the zone in the zone map.
+ */
+#define zone_word(sb, bit) \
+	(&((uint32_t *)(sb)->zmap[(bit)/ZMAP_BITS]->data)[((bit)%ZMAP_BITS)/32])
+
+/**
+ * @brief Gets the word of the reserved zone map where a zone lies.
+ * 
+ * @param sb  Superblock.
+ * @param bit Bit number of the zone in the zone map.
+ */
+#define zone_rword(sb, bit) \
+	(&(sb)->rmap[(bit)/ZMAP_BITS][((bit)%ZMAP_BITS)/32])
+
+/**
+ * @brief Asserts if a zone is free, that is, neither used nor reserved.
+ * 
+ * @param sb  Superblock.
+ * @param bit Bit number of the zone in the zone map.
+ */
+#define zone_isfree(sb, bit) \
+	(!((*zone_word(sb, bit) | *zone_rword(sb, bit)) & (1 << ((bit) & 31))))
+
+/**
+ * @brief Marks a zone as used or free in the zone map.
+ * 
+ * @param sb   Superblock.
+ * @param bit  Bit number of the zone in the zone map.
+ * @param used Mark zone as used?
+ * 
+ * @note The superblock must be locked.
+ */
+PRIVATE void zone_mark(struct superblock *sb, bit_t bit, int used)
+{
+	if (used)
+		bitmap_set(sb->zmap[bit/ZMAP_BITS]->data, bit%ZMAP_BITS);
+	else
+		bitmap_clear(sb->zmap[bit/ZMAP_BITS]->data, bit%ZMAP_BITS);
+	
+	buffer_dirty(sb->zmap[bit/ZMAP_BITS], 1);
+	sb->flags |= SUPERBLOCK_DIRTY;
+}
+
+/**
+ * @brief Reserves or unreserves a zone.
+ * 
+ * @details Reservations live in the in-core reserved zone map only, so that
+ *          they are never written to disk.
+ * 
+ * @param sb       Superblock.
+ * @param bit      Bit number of the zone in the zone map.
+ * @param reserved Mark zone as reserved?
+ * 
+ * @note The superblock must be locked.
+ */
+PRIVATE void zone_reserve(struct superblock *sb, bit_t bit, int reserved)
+{
+	if (reserved)
+		*zone_rword(sb, bit) |= (1 << (bit & 31));
+	else
+		*zone_rword(sb, bit) &= ~(1 << (bit & 31));
+}
+
+/**
+ * @brief Searches for a free zone.
+ * 
+ * @details Searches the zone map a word at a time, starting from the word
+ *          where @p goal lies and wrapping around. A wholly free word is
+ *          preferred, so that a new extent is started where the file can
+ *          grow contiguously. Otherwise, the first free zone found is used.
+ * 
+ * @param sb   Superblock.
+ * @param goal Bit number of the zone to start from.
+ * 
+ * @returns The bit number of a free zone, or #BITMAP_FULL if there is none.
+ * 
+ * @note The superblock must be locked.
+ */
+PRIVATE bit_t zone_search(struct superblock *sb, bit_t goal)
+{
+	bit_t bit;       /* Working bit.        */
+	bit_t any;       /* First free zone.    */
+	bit_t nbits;     /* Number of zones.    */
+	uint32_t word;   /* Working word.       */
+	unsigned nwords; /* Number of words.    */
+	unsigned w;      /* Working word index. */
+	
+	nbits = sb->zones - sb->first_data_block;
+	nwords = (nbits + 31) >> 5;
+	any = BITMAP_FULL;
+	
+	w = goal >> 5;
+	for (unsigned i = 0; i < nwords; i++, w = (w + 1 < nwords) ? w + 1 : 0)
+	{
+		bit = w << 5;
+		word = *zone_word(sb, bit) | *zone_rword(sb, bit);
+		
+		/* Zones past the end of the device are not free. */
+		if (bit + 32 > nbits)
+			word |= ~((1u << (nbits - bit)) - 1);
+		
+		/* Wholly free word. */
+		if (word == 0)
+			return (bit);
+		
+		/* Remember first free zone. */
+		if ((word != 0xffffffff) && (any == BITMAP_FULL))
+			any = bit + __builtin_ctz(~word);
+	}
+	
+	return (any);
+}
+
+/**
+ * @brief Releases the preallocated blocks of a file.
+ * 
+ * @param sb Superblock.
+ * @param ip File.
+ * 
+ * @note The superblock must be locked.
+ */
+PRIVATE void block_unreserve(struct superblock *sb, struct inode *ip)
+{
+	while (ip->nprealloc > 0)
+	{
+		ip->nprealloc--;
+		zone_reserve(sb, ip->prealloc+ip->nprealloc-sb->first_data_block, 0);
+	}
+	
+	if (ip->prealloc < sb->zsearch)
+		sb->zsearch = ip->prealloc;
+}
+
 /**
  * @brief Allocates a disk block.
  * 
- * @details Allocates a disk block by searching in the bitmap of blocks for a
- *          free block.
+ * @details Allocates a disk block for the file pointed to by @p ip, trying to
+ *          place it at @p goal, usually right after the previous block of the
+ *          file. Regular files preallocate a window of blocks following the
+ *          newly allocated one, so that files that are written concurrently
+ *          do not interleave their blocks on disk. The window is reserved
+ *          in-core only, and it is released when the file is no longer in
+ *          use.
  * 
- * @param sb Superblock in which the disk block should be allocated.
+ * @param sb   Superblock in which the disk block should be allocated.
+ * @param ip   File for which the disk block is allocated.
+ * @param goal Preferred disk block, or #BLOCK_NULL if none.
  * 
  * @return Upon successful completion, the block number of the allocated block
  *         is returned. Upon failed, #BLOCK_NULL is returned instead.
  * 
  * @note The superblock must be locked.
  */
-PRIVATE block_t block_alloc(struct superblock *sb)
+PRIVATE block_t block_alloc
+(struct superblock *sb, struct inode *ip, block_t goal)
 {
 	bit_t bit;          /* Bit number in the bitmap. */
+	bit_t nbits;        /* Number of zones.          */
 	block_t num;        /* Block number.             */
-	block_t blk;        /* Working block.            */
-	block_t firstblk;   /* First block to check.     */
 	struct buffer *buf; /* Working buffer.           */
-
-	/* Search for a free block. */
-	firstblk = (sb->zsearch - sb->first_data_block)/(BLOCK_SIZE << 3);
-	blk = firstblk;
-	do
+	
+	/* Take block from preallocation window. */
+	if (ip->nprealloc > 0)
 	{
-		bit = bitmap_first_free(sb->zmap[blk]->data, BLOCK_SIZE);
-		
-		/* Found. */
-		if (bit != BITMAP_FULL)
+		if (ip->prealloc == goal)
+		{
+			num = ip->prealloc++;
+			ip->nprealloc--;
+			bit = num - sb->first_data_block;
+			zone_reserve(sb, bit, 0);
+			zone_mark(sb, bit, 1);
 			goto found;
+		}
 		
-		/* Wrap around. */
-		blk = (blk + 1 < sb->zmap_blocks) ? blk + 1 : 0;
-	} while (blk != firstblk);
+		block_unreserve(sb, ip);
+	}
 	
-	return (BLOCK_NULL);
-
-found:
-
-	num =  sb->first_data_block + bit + blk*(BLOCK_SIZE << 3);
+	/* No goal, so start from last allocation. */
+	if ((goal < sb->first_data_block) || (goal >= sb->zones))
+		goal = sb->zsearch;
+	
+	nbits = sb->zones - sb->first_data_block;
+	bit = goal - sb->first_data_block;
+	
+	/* Search for a free block. */
+	if ((bit >= nbits) || (!zone_isfree(sb, bit)))
+	{
+		if ((bit = zone_search(sb, (bit < nbits) ? bit : 0)) == BITMAP_FULL)
+			return (BLOCK_NULL);
+	}
+	
+	zone_mark(sb, bit, 1);
+	num = sb->first_data_block + bit;
+	
+	/* Preallocate following blocks. */
+	ip->prealloc = num + 1;
+	if (S_ISREG(ip->mode))
+	{
+		while (ip->nprealloc < PREALLOC_MAX)
+		{
+			if (++bit >= nbits)
+				break;
+			if (!zone_isfree(sb, bit))
+				break;
+			
+			zone_reserve(sb, bit, 1);
+			ip->nprealloc++;
+		}
+	}
 	
 	/* 
 	 * Remember disk block number to 
 	 * speedup next block allocation.
 	 */
-	sb->zsearch = num;
+	sb->zsearch = ip->prealloc + ip->nprealloc;
 	
-	/* Allocate block. */
-	bitmap_set(sb->zmap[blk]->data, bit);
-	sb->zmap[blk]->flags |= BUFFER_DIRTY;
-	sb->flags |= SUPERBLOCK_DIRTY;
+found:
 	
 	/* Clean block to avoid security issues. */
-	buf = bread(sb->dev, blk);	
+	buf = bget(sb->dev, num);
 	kmemset(buf->data, 0, BLOCK_SIZE);
-	buf->flags |= BUFFER_DIRTY;
+	buffer_dirty(buf, 1);
 	brelse(buf);
 	
 	return (num);
 }
 
+/**
+ * @brief Releases the preallocated blocks of a file.
+ * 
+ * @param ip File.
+ * 
+ * @note @p ip must be locked.
+ */
+PUBLIC void block_release(struct inode *ip)
+{
+	/* Nothing to be done. */
+	if (ip->nprealloc == 0)
+		return;
+	
+	superblock_lock(ip->sb);
+	block_unreserve(ip->sb, ip);
+	superblock_unlock(ip->sb);
+}
+
 /**
  * @brief Frees a direct disk block.
  * 
@@ -105,9 +297,6 @@ found:
  */
 PRIVATE void block_free_direct(struct superblock *sb, block_t num)
 {
-	unsigned idx; /* Bitmap index.  */
-	unsigned off; /* Bitmap offset. */
-	
 	/* Nothing to be done. */
 	if (num == BLOCK_NULL)
 		return;
@@ -119,19 +308,8 @@ PRIVATE void block_free_direct(struct superblock *sb, block_t num)
 	if (num < sb->zsearch)
 		sb->zsearch = num;
 	
-	num -= sb->first_data_block;
-	
-	/*
-	 * Compute block index and offset 
-	 * in the bitmap.
-	 */
-	idx = num/(BLOCK_SIZE << 3);
-	off = num%(BLOCK_SIZE << 3);
-	
 	/* Free disk block. */
-	bitmap_clear(sb->zmap[idx]->data, off);
-	sb->zmap[idx]->flags |= BUFFER_DIRTY;
-	sb->flags |= SUPERBLOCK_DIRTY;
+	zone_mark(sb, num - sb->first_data_block, 0);
 }
 
 /**
@@ -253,6 +431,7 @@ PUBLIC block_t block_map(struct inode *ip, off_t off, int create)
 {
 	block_t phys;       /* Physical block number. */
 	block_t logic;      /* Logical block number.  */
+	block_t goal;       /* Preferred block.       */
 	struct buffer *buf; /* Underlying buffer.     */
 	
 	logic = off/BLOCK_SIZE;
@@ -277,8 +456,10 @@ PUBLIC block_t block_map(struct inode *ip, off_t off, int create)
 		/* Create direct block. */
 		if (ip->blocks[logic] == BLOCK_NULL && create)
 		{
+			goal = (logic > 0) ? ip->blocks[logic - 1] + 1 : BLOCK_NULL;
+			
 			superblock_lock(ip->sb);
-			phys = block_alloc(ip->sb);
+			phys = block_alloc(ip->sb, ip, goal);
 			superblock_unlock(ip->sb);
 			
 			if (phys != BLOCK_NULL)
@@ -299,8 +480,10 @@ PUBLIC block_t block_map(struct inode *ip, off_t off, int create)
 		/* Create single indirect block. */
 		if (ip->blocks[ZONE_SINGLE] == BLOCK_NULL && create)
 		{
+			goal = ip->blocks[NR_ZONES_DIRECT - 1] + 1;
+			
 			superblock_lock(ip->sb);
-			phys = block_alloc(ip->sb);
+			phys = block_alloc(ip->sb, ip, goal);
 			superblock_unlock(ip->sb);
 			
 			if (phys != BLOCK_NULL)
@@ -319,14 +502,17 @@ PUBLIC block_t block_map(struct inode *ip, off_t off, int create)
 		/* Create direct block. */
 		if (((block_t *)buf->data)[logic] == BLOCK_NULL && create)
 		{
+			goal = (logic > 0) ?
+				((block_t *)buf->data)[logic - 1] + 1 : phys + 1;
+			
 			superblock_lock(ip->sb);
-			phys = block_alloc(ip->sb);
+			phys = block_alloc(ip->sb, ip, goal);
 			superblock_unlock(ip->sb);
 			
 			if (phys != BLOCK_NULL)
 			{
 				((block_t *)buf->data)[logic] = phys;
-				buf->flags |= BUFFER_DIRTY;
+				buffer_dirty(buf, 1);
 				inode_touch(ip);
 			}
 		}
@@ -17,6 +17,7 @@
  * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <nanvix/clock.h>
 #include <nanvix/const.h>
 #include <nanvix/dev.h>
 #include <nanvix/fs.h>
@@ -47,20 +48,110 @@
 	#error "hard disk too small"
 #endif
 
+/**
+ * @brief Maximum number of block buffers.
+ * 
+ * @details Besides the NR_BUFFERS buffers that live in low memory, up to
+ *          BUFFERS_POOL_RATIO percent of the kernel page pool is taken at
+ *          boot time to hold block buffers.
+ */
+#define BUFFERS_MAX \
+	(NR_BUFFERS + ((KPOOL_SIZE/BLOCK_SIZE)*BUFFERS_POOL_RATIO)/100)
+
 /**
  * @brief Hash table size of the block buffer cache.
  */
-#define BUFFERS_HASHTAB_SIZE 53
+#define BUFFERS_HASHTAB_SIZE 1024
+
+/*
+ * Hash table size should be a power of two,
+ * so that we can use a mask in the hash function.
+ */
+#if (BUFFERS_HASHTAB_SIZE & (BUFFERS_HASHTAB_SIZE - 1))
+	#error "hash table size should be a power of two"
+#endif
+
+/**
+ * @brief Maximum number of dirty buffers before forcing write-back.
+ */
+#define BUFFERS_DIRTY_MAX ((nbuffers*BUFFERS_DIRTY_RATIO)/100)
+
+/**
+ * @name Replacement queues
+ * 
+ * @details Buffers are managed with the 2Q policy. A block that is brought
+ *          to the cache enters the A1 queue, and it is only promoted to the
+ *          Am queue if it is requested again after having been evicted from
+ *          A1. The identity of blocks that are evicted from A1 is remembered
+ *          for a while in the A1out ghost queue. Therefore, a single scan
+ *          over a large file does not flush frequently used blocks.
+ */
+/**@{*/
+#define QUEUE_NONE 0 /**< Buffers holding no valid block. */
+#define QUEUE_A1   1 /**< Blocks used once.              */
+#define QUEUE_AM   2 /**< Frequently used blocks.        */
+#define NR_QUEUES  3 /**< Number of queues.              */
+/**@}*/
+
+/**
+ * @brief Target size of the A1 queue.
+ */
+#define QUEUE_A1_MAX (nbuffers/4)
+
+/**
+ * @brief Size of the A1out ghost queue.
+ */
+#define NR_GHOSTS (BUFFERS_MAX/2)
+
+/**
+ * @brief Number of devices for which statistics are kept.
+ */
+#define NR_BSTATS 8
+
+/**
+ * @brief Ghost entry.
+ */
+struct ghost
+{
+	dev_t dev;          /**< Device.                    */
+	block_t num;        /**< Block number.              */
+	struct ghost *next; /**< Next ghost in hash table. */
+};
 
 /**
  * @brief Block buffers.
  */
-PRIVATE struct buffer buffers[NR_BUFFERS];
+PRIVATE struct buffer buffers[BUFFERS_MAX];
+
+/**
+ * @brief Number of block buffers.
+ */
+PRIVATE unsigned nbuffers = 0;
+
+/**
+ * @brief Lists of free block buffers, one for each replacement queue.
+ */
+PRIVATE struct buffer free_buffers[NR_QUEUES];
+
+/**
+ * @brief Number of block buffers in each replacement queue.
+ */
+PRIVATE unsigned queue_size[NR_QUEUES];
+
+/**
+ * @brief A1out ghost queue.
+ */
+PRIVATE struct ghost ghosts[NR_GHOSTS];
+
+/**
+ * @brief Next ghost entry to be recycled.
+ */
+PRIVATE unsigned ghost_next = 0;
 
 /**
- * @brief List of free block buffers.
+ * @brief Ghost hash table.
  */
-PRIVATE struct buffer free_buffers;
+PRIVATE struct ghost *ghost_hashtab[BUFFERS_HASHTAB_SIZE];
 
 /**
  * @brief Processes waiting for any block.
@@ -75,6 +166,27 @@ PRIVATE struct process *chain = NULL;
  */
 PRIVATE struct buffer hashtab[BUFFERS_HASHTAB_SIZE];
 
+/**
+ * @brief Number of dirty block buffers.
+ */
+PRIVATE unsigned ndirty = 0;
+
+/**
+ * @brief Flusher daemon.
+ * 
+ * @details Chain where the flusher daemon sleeps, waiting for work to do.
+ */
+PRIVATE struct process *flusher = NULL;
+
+/**
+ * @brief Block buffer cache statistics.
+ */
+PRIVATE struct bstat
+{
+	dev_t dev;       /**< Device.       */
+	unsigned hits;   /**< Cache hits.   */
+	unsigned misses; /**< Cache misses. */
+} bstats[NR_BSTATS];
 
 /**
  * @brief Hash function for block buffer hash table.
@@ -83,7 +195,150 @@ PRIVATE struct buffer hashtab[BUFFERS_HASHTAB_SIZE];
  *          table slot.
  */
 #define HASH(dev, block) \
-	(((dev)^(block))%BUFFERS_HASHTAB_SIZE)
+	(((dev)^(block)) & (BUFFERS_HASHTAB_SIZE - 1))
+
+/**
+ * @brief Remembers a block that was evicted from the A1 queue.
+ * 
+ * @param dev Device number.
+ * @param num Block number.
+ */
+PRIVATE void ghost_insert(dev_t dev, block_t num)
+{
+	struct ghost *g;   /* Working ghost.   */
+	struct ghost **pp; /* Ghost hash link. */
+	
+	g = &ghosts[ghost_next];
+	ghost_next = (ghost_next + 1) % (nbuffers/2);
+	
+	/* Forget oldest block. */
+	if ((g->dev != 0) || (g->num != 0))
+	{
+		pp = &ghost_hashtab[HASH(g->dev, g->num)];
+		while (*pp != g)
+			pp = &(*pp)->next;
+		*pp = g->next;
+	}
+	
+	g->dev = dev;
+	g->num = num;
+	g->next = ghost_hashtab[HASH(dev, num)];
+	ghost_hashtab[HASH(dev, num)] = g;
+}
+
+/**
+ * @brief Forgets a block that was evicted from the A1 queue.
+ * 
+ * @param dev Device number.
+ * @param num Block number.
+ * 
+ * @returns Non-zero if the block was remembered, and zero otherwise.
+ */
+PRIVATE int ghost_remove(dev_t dev, block_t num)
+{
+	struct ghost *g;   /* Working ghost.   */
+	struct ghost **pp; /* Ghost hash link. */
+	
+	for (pp = &ghost_hashtab[HASH(dev, num)]; *pp != NULL; pp = &g->next)
+	{
+		g = *pp;
+		
+		/* Found. */
+		if ((g->dev == dev) && (g->num == num))
+		{
+			*pp = g->next;
+			g->dev = 0;
+			g->num = 0;
+			g->next = NULL;
+			return (1);
+		}
+	}
+	
+	return (0);
+}
+
+/**
+ * @brief Chooses a free block buffer to be reassigned.
+ * 
+ * @details Chooses a free block buffer following the 2Q policy. Buffers that
+ *          hold no valid block are chosen first. Then, the oldest buffer in
+ *          the A1 queue is chosen if that queue is above its target size,
+ *          otherwise the least recently used buffer in the Am queue is
+ *          chosen. Clean buffers are preferred, so that we do not have to
+ *          wait for a dirty one to be written back.
+ * 
+ * @returns A free block buffer, or a null pointer if there is none.
+ * 
+ * @note Interrupts must be disabled.
+ */
+PRIVATE struct buffer *bvictim(void)
+{
+	int i;              /* Loop index.          */
+	int order[2];       /* Queues to look into. */
+	struct buffer *buf; /* Working buffer.      */
+	
+	/* Buffer holding no valid block. */
+	buf = free_buffers[QUEUE_NONE].free_next;
+	if (buf != &free_buffers[QUEUE_NONE])
+		return (buf);
+	
+	/* Choose the queue to evict from. */
+	if (queue_size[QUEUE_A1] > QUEUE_A1_MAX)
+		order[0] = QUEUE_A1, order[1] = QUEUE_AM;
+	else
+		order[0] = QUEUE_AM, order[1] = QUEUE_A1;
+	
+	/* Look for a clean buffer. */
+	for (i = 0; i < 2; i++)
+	{
+		buf = free_buffers[order[i]].free_next;
+		while ((buf != &free_buffers[order[i]]) && (buf->flags & BUFFER_DIRTY))
+			buf = buf->free_next;
+		
+		if (buf != &free_buffers[order[i]])
+			return (buf);
+	}
+	
+	/* All free buffers are dirty. */
+	for (i = 0; i < 2; i++)
+	{
+		buf = free_buffers[order[i]].free_next;
+		if (buf != &free_buffers[order[i]])
+		{
+			wakeup(&flusher);
+			return (buf);
+		}
+	}
+	
+	return (NULL);
+}
+
+/**
+ * @brief Gets block buffer cache statistics of a device.
+ * 
+ * @param dev Device number.
+ * 
+ * @returns Statistics of the device, or a null pointer if there is no room
+ *          to keep them.
+ */
+PRIVATE struct bstat *bstat_get(dev_t dev)
+{
+	for (unsigned i = 0; i < NR_BSTATS; i++)
+	{
+		/* Found. */
+		if (bstats[i].dev == dev)
+			return (&bstats[i]);
+		
+		/* Start keeping statistics. */
+		if (bstats[i].dev == 0)
+		{
+			bstats[i].dev = dev;
+			return (&bstats[i]);
+		}
+	}
+	
+	return (NULL);
+}
 
 /**
  * @brief Gets a block buffer from the block buffer cache.
@@ -98,6 +353,9 @@ PRIVATE struct buffer hashtab[BUFFERS_HASHTAB_SIZE];
  *          requested block is returned. In this case, the block buffer is 
  *          ensured to be locked, and may be, or may be not, valid.
  *          Upon failure, a null pointer NULL is returned instead.
+ * 
+ * @note Blocks of memory-backed devices are mapped, instead of read, so
+ *       buffers holding them are always valid.
  */
 PRIVATE struct buffer *getblk(dev_t dev, block_t num)
 {
@@ -148,7 +406,7 @@ repeat:
 	 * There are no free buffers so we need to
 	 * wait for one to become free.
 	 */
-	if (&free_buffers == free_buffers.free_next)
+	if ((buf = bvictim()) == NULL)
 	{
 		kprintf("fs: no free buffers");
 		sleep(&chain, PRIO_BUFFER);
@@ -156,7 +414,6 @@ repeat:
 	}
 	
 	/* Remove buffer from the free list. */
-	buf = free_buffers.free_next;
 	buf->free_prev->free_next = buf->free_next;
 	buf->free_next->free_prev = buf->free_prev;
 	buf->count++;
@@ -177,11 +434,29 @@ repeat:
 	buf->hash_prev->hash_next = buf->hash_next;
 	buf->hash_next->hash_prev = buf->hash_prev;
 	
+	/* Remember block evicted from A1. */
+	if (buf->queue == QUEUE_A1)
+		ghost_insert(buf->dev, buf->num);
+	
+	/* Block was recently evicted from A1, so it is frequently used. */
+	queue_size[buf->queue]--;
+	buf->queue = (ghost_remove(dev, num)) ? QUEUE_AM : QUEUE_A1;
+	queue_size[buf->queue]++;
+	
 	/* Reassign device and block number. */
 	buf->dev = dev;
 	buf->num = num;
 	buf->flags &= ~BUFFER_VALID;
 	
+	/*
+	 * The block lies in memory, so point the
+	 * buffer straight to it, instead of copying.
+	 */
+	if ((buf->data = bdev_map(dev, num)) != NULL)
+		buf->flags |= BUFFER_VALID;
+	else
+		buf->data = buf->mem;
+	
 	/* Place buffer in a new hash queue. */
 	hashtab[i].hash_next->hash_prev = buf;
 	buf->hash_prev = &hashtab[i];
@@ -248,12 +523,17 @@ PUBLIC void blkunlock(struct buffer *buf)
  */
 PUBLIC void brelse(struct buffer *buf)
 {
+	struct buffer *head; /* Free list. */
+	
 	disable_interrupts();
 	
 	/* Double free. */
 	if (buf->count == 0)
 		kpanic("freeing buffer twice");
 	
+	/* Asynchronous read has completed. */
+	buf->flags &= ~BUFFER_ASYNC;
+	
 	/* No more references. */
 	if (--buf->count == 0)
 	{
@@ -262,23 +542,29 @@ PUBLIC void brelse(struct buffer *buf)
 		 * for any block to become free.
 		 */
 		wakeup(&chain);
-					
-		/* Frequently used buffer (insert in the end). */
-		if ((buf->flags & BUFFER_VALID) && (buf->flags & BUFFER_DIRTY))
-		{	
-			free_buffers.free_prev->free_next = buf;
-			buf->free_prev = free_buffers.free_prev;
-			free_buffers.free_prev = buf;
-			buf->free_next = &free_buffers;
-		}
+		
+		/* Buffer holds no valid block (insert in the begin). */
+		if (!(buf->flags & BUFFER_VALID))
+		{
+			queue_size[buf->queue]--;
+			buf->queue = QUEUE_NONE;
+			queue_size[buf->queue]++;
 			
-		/* Not frequently used buffer (insert in the begin). */
+			head = &free_buffers[QUEUE_NONE];
+			head->free_next->free_prev = buf;
+			buf->free_prev = head;
+			buf->free_next = head->free_next;
+			head->free_next = buf;
+		}
+		
+		/* Most recently used buffer (insert in the end). */
 		else
-		{	
-			free_buffers.free_next->free_prev = buf;
-			buf->free_prev = &free_buffers;
-			buf->free_next = free_buffers.free_next;
-			free_buffers.free_next = buf;
+		{
+			head = &free_buffers[buf->queue];
+			head->free_prev->free_next = buf;
+			buf->free_prev = head->free_prev;
+			head->free_prev = buf;
+			buf->free_next = head;
 		}
 	}
 
@@ -305,13 +591,23 @@ PUBLIC void brelse(struct buffer *buf)
  */
 PUBLIC struct buffer *bread(dev_t dev, block_t num)
 {
-	struct buffer *buf;
+	struct buffer *buf; /* Buffer.           */
+	struct bstat *stat; /* Cache statistics. */
 	
 	buf = getblk(dev, num);
 	
+	stat = bstat_get(dev);
+	
 	/* Valid buffer? */
 	if (buf->flags & BUFFER_VALID)
+	{
+		if (stat != NULL)
+			stat->hits++;
 		return (buf);
+	}
+	
+	if (stat != NULL)
+		stat->misses++;
 
 	bdev_readblk(buf);
 	
@@ -322,6 +618,125 @@ PUBLIC struct buffer *bread(dev_t dev, block_t num)
 	return (buf);
 }
 
+/**
+ * @brief Gets a block buffer for overwriting.
+ * 
+ * @details Gets a buffer for the block numbered num of the device numbered
+ *          dev, without reading the block from the device. The buffer is
+ *          marked as valid, so the caller must overwrite it as a whole.
+ * 
+ * @param dev Device number.
+ * @param num Block number.
+ * 
+ * @returns Upon successful completion, a pointer to a buffer for the
+ *          requested block is returned. In this case, the block buffer is
+ *          ensured to be locked. Upon failure, a NULL pointer is returned
+ *          instead.
+ * 
+ * @note The device number should be valid.
+ * @note The block number should be valid.
+ */
+PUBLIC struct buffer *bget(dev_t dev, block_t num)
+{
+	struct buffer *buf; /* Buffer. */
+	
+	buf = getblk(dev, num);
+	buf->flags |= BUFFER_VALID;
+	
+	return (buf);
+}
+
+/**
+ * @brief Reads ahead blocks from a device.
+ * 
+ * @details Starts reading asynchronously n consecutive blocks from the
+ *          device numbered dev, starting at the block numbered num, into the
+ *          block buffer cache. Blocks that are not cached are gathered into
+ *          runs, so that each run is read in a single device operation.
+ *          Nothing is done for blocks that are already cached, and reading
+ *          ahead stops if no buffer is available right now, so that the
+ *          calling process never waits here.
+ * 
+ * @param dev Device number.
+ * @param num Number of the first block.
+ * @param n   Number of blocks.
+ * 
+ * @note The device number should be valid.
+ * @note The block numbers should be valid.
+ */
+PUBLIC void breada(dev_t dev, block_t num, unsigned n)
+{
+	unsigned i;                         /* Hash table index.  */
+	unsigned nbufs;                     /* Buffers in run.    */
+	struct buffer *buf;                 /* Buffer.            */
+	struct buffer *bufs[READAHEAD_MAX]; /* Run of buffers.    */
+	
+	nbufs = 0;
+	
+	for (/* noop */; n > 0; num++, n--)
+	{
+		/* Run is full. */
+		if (nbufs == READAHEAD_MAX)
+		{
+			bdev_readblks(bufs, nbufs);
+			nbufs = 0;
+		}
+		
+		i = HASH(dev, num);
+		
+		disable_interrupts();
+		
+		/* Block is cached or being read. */
+		buf = hashtab[i].hash_next;
+		while ((buf != &hashtab[i]) && ((buf->dev != dev) || (buf->num != num)))
+			buf = buf->hash_next;
+		
+		if (buf != &hashtab[i])
+		{
+			enable_interrupts();
+			goto skip;
+		}
+		
+		/* No free buffers. */
+		if (bvictim() == NULL)
+		{
+			enable_interrupts();
+			break;
+		}
+		
+		enable_interrupts();
+		
+		buf = getblk(dev, num);
+		
+		/* Someone else has read the block. */
+		if (buf->flags & BUFFER_VALID)
+		{
+			brelse(buf);
+			goto skip;
+		}
+		
+		/*
+		 * The buffer is marked as valid right now, but it
+		 * stays locked until the read completes. The low-level
+		 * I/O function shall release the buffer.
+		 */
+		buf->flags |= BUFFER_VALID | BUFFER_ASYNC;
+		bufs[nbufs++] = buf;
+		continue;
+
+skip:
+		/* Run is broken. */
+		if (nbufs > 0)
+		{
+			bdev_readblks(bufs, nbufs);
+			nbufs = 0;
+		}
+	}
+	
+	if (nbufs > 0)
+		bdev_readblks(bufs, nbufs);
+}
+
 /**
  * @brief Writes a block buffer to the underlying device.
  * 
@@ -352,16 +767,118 @@ PUBLIC void bwrite(struct buffer *buf)
 	bdev_writeblk(buf);
 }
 
+/**
+ * @brief Writes back a batch of dirty block buffers.
+ * 
+ * @details Grabs up to BUFFERS_FLUSH_BATCH free dirty block buffers that have
+ *          aged enough, or any free dirty buffers if there are too many of
+ *          them, and writes them back asynchronously sorted by device and
+ *          block number. Runs of consecutive blocks are written back in a
+ *          single device operation.
+ * 
+ * @param force Write back dirty buffers regardless of their age?
+ * 
+ * @returns The number of block buffers that were written back.
+ */
+PRIVATE int bflush(int force)
+{
+	int i, j, n;                               /* Loop indexes.     */
+	struct buffer *buf;                        /* Working buffer.   */
+	struct buffer *batch[BUFFERS_FLUSH_BATCH]; /* Buffers to write. */
+	
+	n = 0;
+	
+	disable_interrupts();
+	
+	/* Too many dirty buffers. */
+	if (ndirty > BUFFERS_DIRTY_MAX)
+		force = 1;
+	
+	for (buf = &buffers[0]; buf < &buffers[nbuffers]; buf++)
+	{
+		/* Nothing to write back. */
+		if (!(buf->flags & BUFFER_VALID) || !(buf->flags & BUFFER_DIRTY))
+			continue;
+		
+		/* Buffer in use. */
+		if ((buf->count > 0) || (buf->flags & BUFFER_LOCKED))
+			continue;
+		
+		/* Not old enough. */
+		if (!force && (ticks - buf->dirtied < BUFFERS_DIRTY_AGE*CLOCK_FREQ))
+			continue;
+		
+		/*
+		 * Grab buffer. Remove it from the free
+		 * list, since a call to brelse() will follow.
+		 */
+		buf->flags |= BUFFER_LOCKED;
+		buf->count++;
+		buf->free_prev->free_next = buf->free_next;
+		buf->free_next->free_prev = buf->free_prev;
+		
+		/* Keep batch sorted by device and block number. */
+		for (i = n; i > 0; i--)
+		{
+			struct buffer *prev = batch[i - 1];
+			
+			if ((prev->dev < buf->dev) ||
+				((prev->dev == buf->dev) && (prev->num < buf->num)))
+				break;
+			batch[i] = prev;
+		}
+		batch[i] = buf;
+		
+		/* Batch is full. */
+		if (++n == BUFFERS_FLUSH_BATCH)
+			break;
+	}
+	
+	enable_interrupts();
+	
+	/*
+	 * This will cause the buffers to be written
+	 * back to disk and then released.
+	 */
+	for (i = 0; i < n; i += j)
+	{
+		/* Find run of consecutive blocks. */
+		for (j = 1; i + j < n; j++)
+		{
+			if (batch[i + j]->dev != batch[i]->dev)
+				break;
+			if (batch[i + j]->num != batch[i]->num + j)
+				break;
+		}
+		
+		bdev_writeblks(&batch[i], j);
+	}
+	
+	return (n);
+}
+
 /**
  * @brief Synchronizes the block buffer cache.
  * 
- * @details Flushes all valid block buffers onto underlying devices.
+ * @details Flushes all valid block buffers onto underlying devices, and then
+ *          flushes the caches of these devices.
  */
 PUBLIC void bsync(void)
 {
+	unsigned ndevs;        /* Number of devices. */
+	dev_t devs[NR_BSTATS]; /* Devices to flush.  */
+	
+	ndevs = 0;
+	
+	/* Write back free buffers in runs. */
+	while (bflush(1) == BUFFERS_FLUSH_BATCH)
+		noop();
+	
 	/* Synchronize buffers. */
-	for (struct buffer *buf = &buffers[0]; buf < &buffers[NR_BUFFERS]; buf++)
+	for (struct buffer *buf = &buffers[0]; buf < &buffers[nbuffers]; buf++)
 	{
+		unsigned i;
+		
 		blklock(buf);
 			
 		/* Skip invalid buffers. */
@@ -371,6 +888,15 @@ PUBLIC void bsync(void)
 			continue;
 		}
 		
+		/* Remember device. */
+		for (i = 0; i < ndevs; i++)
+		{
+			if (devs[i] == buf->dev)
+				break;
+		}
+		if ((i == ndevs) && (ndevs < NR_BSTATS))
+			devs[ndevs++] = buf->dev;
+		
 		/*
 		 * Prevent double free, since a call
 		 * to brelse() will follow.
@@ -389,6 +915,46 @@ PUBLIC void bsync(void)
 		 */
 		bwrite(buf);
 	}
+	
+	/*
+	 * Make sure that everything
+	 * reaches permanent storage.
+	 */
+	for (unsigned i = 0; i < ndevs; i++)
+		bdev_flush(devs[i]);
+}
+
+/**
+ * @brief Block buffer cache flusher daemon.
+ * 
+ * @details Periodically writes back dirty block buffers, so that processes
+ *          seldom have to wait for a dirty buffer to be written back when
+ *          they need a free one. The daemon is also woken up when there are
+ *          too many dirty buffers, and it terminates when the system is
+ *          shutting down.
+ * 
+ * @note This function never returns.
+ */
+PUBLIC void bflushd(void)
+{
+	kstrncpy(curr_proc->name, "bflushd", NAME_MAX);
+	
+	while (!shutting_down)
+	{
+		/* There may be more work to do. */
+		if (bflush(0) == BUFFERS_FLUSH_BATCH)
+			continue;
+		
+		/* Wait for the next period. */
+		disable_interrupts();
+		curr_proc->alarm = ticks + BUFFERS_FLUSH_INTERVAL*CLOCK_FREQ;
+		sleep(&flusher, PRIO_SIG);
+		curr_proc->alarm = 0;
+		curr_proc->received = 0;
+		enable_interrupts();
+	}
+	
+	die(0);
 }
 
 /**
@@ -404,7 +970,27 @@ PUBLIC void bsync(void)
  */
 PUBLIC inline void buffer_dirty(struct buffer *buf, int set)
 {
-	buf->flags = (set) ? buf->flags | BUFFER_DIRTY : buf->flags & ~BUFFER_DIRTY;
+	disable_interrupts();
+	
+	/* Buffer is getting dirty. */
+	if ((set) && !(buf->flags & BUFFER_DIRTY))
+	{
+		buf->flags |= BUFFER_DIRTY;
+		buf->dirtied = ticks;
+		
+		/* Too many dirty buffers. */
+		if (++ndirty > BUFFERS_DIRTY_MAX)
+			wakeup(&flusher);
+	}
+	
+	/* Buffer is getting clean. */
+	else if ((!set) && (buf->flags & BUFFER_DIRTY))
+	{
+		buf->flags &= ~BUFFER_DIRTY;
+		ndirty--;
+	}
+	
+	enable_interrupts();
 }
 
 /**
@@ -473,11 +1059,94 @@ PUBLIC inline int buffer_is_sync(const struct buffer *buf)
 	return (buf->flags & BUFFER_SYNC);
 }
 
+/**
+ * @brief Asserts if a block buffer is marked as asynchronous read.
+ * 
+ * @details Asserts if the block buffer pointed to by buf is marked as 
+ *          asynchronous read.
+ * 
+ * @param buf Buffer to be asserted.
+ * 
+ * @returns Non-zero if the buffer is marked as asynchronous read, and zero
+ *          otherwise.
+ * 
+ * @note The buffer must be locked.
+ */
+PUBLIC inline int buffer_is_async(const struct buffer *buf)
+{
+	return (buf->flags & BUFFER_ASYNC);
+}
+
+/**
+ * @brief Gets block buffer cache statistics of a device.
+ * 
+ * @details Stores the block buffer cache statistics of the device numbered
+ *          dev in the buffer pointed to by buf.
+ * 
+ * @param dev Device number.
+ * @param buf Location where statistics shall be dumped.
+ */
+PUBLIC void bstat(dev_t dev, struct iostat *buf)
+{
+	disable_interrupts();
+	
+	for (unsigned i = 0; i < NR_BSTATS; i++)
+	{
+		/* Found. */
+		if ((bstats[i].dev == dev) && (dev != 0))
+		{
+			buf->io_hits = bstats[i].hits;
+			buf->io_misses = bstats[i].misses;
+			break;
+		}
+	}
+	
+	enable_interrupts();
+}
+
+/**
+ * @brief Sets up a block buffer.
+ * 
+ * @details Sets up the block buffer pointed to by buf, so that it holds no
+ *          valid block and it uses the memory pointed to by ptr to store
+ *          data. The buffer is put in the free list.
+ * 
+ * @param buf Block buffer to be set up.
+ * @param ptr Underlying data.
+ */
+PRIVATE void bsetup(struct buffer *buf, void *ptr)
+{
+	struct buffer *head; /* Free list. */
+	
+	buf->dev = 0;
+	buf->num = 0;
+	buf->data = ptr;
+	buf->mem = ptr;
+	buf->count = 0;
+	buf->flags = 0;
+	buf->chain = NULL;
+	buf->dirtied = 0;
+	buf->queue = QUEUE_NONE;
+	buf->hash_next = buf;
+	buf->hash_prev = buf;
+	
+	/* Insert in the end of the free list. */
+	head = &free_buffers[QUEUE_NONE];
+	head->free_prev->free_next = buf;
+	buf->free_prev = head->free_prev;
+	head->free_prev = buf;
+	buf->free_next = head;
+	queue_size[QUEUE_NONE]++;
+}
+
 /**
  * @brief Initializes the bock buffer cache.
  * 
  * @details Initializes the block buffer cache by putting all buffers in the
- *          free list and cleaning the block buffer hash table.
+ *          free list and cleaning the block buffer hash table. Besides the
+ *          buffers in low memory, the cache takes as many pages as it can
+ *          from the kernel page pool, up to BUFFERS_POOL_RATIO percent of
+ *          the pool.
  * 
  * @note This function shall be called just once. 
  */
@@ -487,35 +1156,40 @@ PUBLIC void binit(void)
 	
 	kprintf("fs: initializing the block buffer cache");
 	
-	/* Initialize block buffers. */
+	/* Initialize the buffer cache. */
+	for (unsigned i = 0; i < NR_QUEUES; i++)
+	{
+		free_buffers[i].free_next = &free_buffers[i];
+		free_buffers[i].free_prev = &free_buffers[i];
+		queue_size[i] = 0;
+	}
+	for (unsigned i = 0; i < BUFFERS_HASHTAB_SIZE; i++)
+	{
+		hashtab[i].hash_prev = &hashtab[i];
+		hashtab[i].hash_next = &hashtab[i];
+		ghost_hashtab[i] = NULL;
+	}
+	
+	/* Buffers in low memory. */
 	ptr = (char *)BUFFERS_VIRT;
 	for (unsigned i = 0; i < NR_BUFFERS; i++)
 	{
-		buffers[i].dev = 0;
-		buffers[i].num = 0;
-		buffers[i].data = ptr;
-		buffers[i].count = 0;
-		buffers[i].flags = 
-			~(BUFFER_VALID | BUFFER_LOCKED | BUFFER_DIRTY | BUFFER_SYNC);
-		buffers[i].chain = NULL;
-		buffers[i].free_next = 
-			(i + 1 == NR_BUFFERS) ? &free_buffers : &buffers[i + 1];
-		buffers[i].free_prev = 
-			(i == 0) ? &free_buffers : &buffers[i - 1];
-		buffers[i].hash_next = &buffers[i];
-		buffers[i].hash_prev = &buffers[i];
-		
+		bsetup(&buffers[nbuffers++], ptr);
 		ptr += BLOCK_SIZE;
 	}
 	
-	/* Initialize the buffer cache. */
-	free_buffers.free_next = &buffers[0];
-	free_buffers.free_prev = &buffers[NR_BUFFERS - 1];
-	for (unsigned i = 0; i < BUFFERS_HASHTAB_SIZE; i++)
+	/* Buffers in the kernel page pool. */
+	while (nbuffers + (PAGE_SIZE/BLOCK_SIZE) <= BUFFERS_MAX)
 	{
-		hashtab[i].hash_prev = &hashtab[i];
-		hashtab[i].hash_next = &hashtab[i];
+		if ((ptr = getkpg(0)) == NULL)
+			break;
+		
+		for (unsigned i = 0; i < PAGE_SIZE/BLOCK_SIZE; i++)
+		{
+			bsetup(&buffers[nbuffers++], ptr);
+			ptr += BLOCK_SIZE;
+		}
 	}
 	
-	kprintf("fs: %d slots in the block buffer cache", NR_BUFFERS);
+	kprintf("fs: %d slots in the block buffer cache", nbuffers);
 }
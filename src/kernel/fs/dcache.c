@@ -0,0 +1,239 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ * 
+ * @brief Directory cache module implementation.
+ * 
+ * @details The directory cache maps (directory, name) pairs to inode
+ *          numbers, so that path name resolution does not have to scan
+ *          directory blocks. Names that were not found are cached as well.
+ */
+
+#include <nanvix/config.h>
+#include <nanvix/const.h>
+#include <nanvix/fs.h>
+#include <nanvix/klib.h>
+#include <limits.h>
+#include "fs.h"
+
+/**
+ * @brief Hash table size.
+ */
+#define HASHTAB_SIZE 67
+
+/**
+ * @brief Directory cache entry.
+ */
+struct dentry
+{
+	dev_t dev;                /**< Device.                         */
+	ino_t dir;                /**< Directory inode number.         */
+	ino_t num;                /**< Inode number.                   */
+	char name[NAME_MAX];      /**< File name.                      */
+	struct dentry *hash_next; /**< Next entry in the hash table.   */
+	struct dentry *lru_next;  /**< Next entry in the LRU list.     */
+	struct dentry *lru_prev;  /**< Previous entry in the LRU list. */
+};
+
+/**
+ * @brief Directory cache entries.
+ */
+PRIVATE struct dentry dentries[NR_DENTRIES];
+
+/**
+ * @brief Directory cache hash table.
+ */
+PRIVATE struct dentry *hashtab[HASHTAB_SIZE];
+
+/**
+ * @brief LRU list of entries (most recently used first).
+ */
+PRIVATE struct dentry lru;
+
+/**
+ * @brief Hash function for the directory cache.
+ */
+PRIVATE unsigned hash(dev_t dev, ino_t dir, const char *name)
+{
+	unsigned h;
+	
+	h = dev ^ dir;
+	for (unsigned i = 0; (i < NAME_MAX) && (name[i] != '\0'); i++)
+		h = (h << 3) + (h >> 29) + name[i];
+	
+	return (h%HASHTAB_SIZE);
+}
+
+/**
+ * @brief Moves an entry to the front of the LRU list.
+ */
+PRIVATE void dentry_touch(struct dentry *d)
+{
+	d->lru_prev->lru_next = d->lru_next;
+	d->lru_next->lru_prev = d->lru_prev;
+	d->lru_next = lru.lru_next;
+	d->lru_prev = &lru;
+	lru.lru_next->lru_prev = d;
+	lru.lru_next = d;
+}
+
+/**
+ * @brief Removes an entry from the hash table.
+ */
+PRIVATE void dentry_unhash(struct dentry *d)
+{
+	struct dentry **pp;
+	
+	for (pp = &hashtab[hash(d->dev, d->dir, d->name)]; *pp != NULL;
+			pp = &(*pp)->hash_next)
+	{
+		/* Found. */
+		if (*pp == d)
+		{
+			*pp = d->hash_next;
+			break;
+		}
+	}
+	
+	d->dir = INODE_NULL;
+}
+
+/**
+ * @brief Searches for an entry in the directory cache.
+ */
+PRIVATE struct dentry *dentry_search(struct inode *dip, const char *name)
+{
+	struct dentry *d;
+	
+	d = hashtab[hash(dip->dev, dip->num, name)];
+	for (/* noop */; d != NULL; d = d->hash_next)
+	{
+		/* Found. */
+		if ((d->dev == dip->dev) && (d->dir == dip->num) &&
+			(!kstrncmp(d->name, name, NAME_MAX)))
+			return (d);
+	}
+	
+	return (NULL);
+}
+
+/**
+ * @brief Looks up a name in the directory cache.
+ * 
+ * @param dip  Directory where the name shall be looked up.
+ * @param name Name to look up.
+ * @param num  Store location for the inode number, which is #INODE_NULL if
+ *             the name is known not to exist.
+ * 
+ * @returns Zero if the name is in the directory cache, and non-zero
+ *          otherwise.
+ */
+PUBLIC int dcache_lookup(struct inode *dip, const char *name, ino_t *num)
+{
+	struct dentry *d;
+	
+	/* Miss. */
+	if ((d = dentry_search(dip, name)) == NULL)
+		return (-1);
+	
+	dentry_touch(d);
+	*num = d->num;
+	
+	return (0);
+}
+
+/**
+ * @brief Inserts a name in the directory cache.
+ * 
+ * @details If the name is already cached, its inode number is updated.
+ * 
+ * @param dip  Directory where the name lives.
+ * @param name Name.
+ * @param num  Inode number, or #INODE_NULL if the name does not exist.
+ */
+PUBLIC void dcache_insert(struct inode *dip, const char *name, ino_t num)
+{
+	unsigned i;
+	struct dentry *d;
+	
+	/* Update entry. */
+	if ((d = dentry_search(dip, name)) != NULL)
+	{
+		dentry_touch(d);
+		d->num = num;
+		return;
+	}
+	
+	/* Recycle least recently used entry. */
+	d = lru.lru_prev;
+	if (d->dir != INODE_NULL)
+		dentry_unhash(d);
+	dentry_touch(d);
+	
+	d->dev = dip->dev;
+	d->dir = dip->num;
+	d->num = num;
+	kstrncpy(d->name, name, NAME_MAX);
+	
+	i = hash(d->dev, d->dir, d->name);
+	d->hash_next = hashtab[i];
+	hashtab[i] = d;
+}
+
+/**
+ * @brief Drops all names of a directory from the directory cache.
+ * 
+ * @param dip Target directory.
+ */
+PUBLIC void dcache_purge(struct inode *dip)
+{
+	for (unsigned i = 0; i < NR_DENTRIES; i++)
+	{
+		/* Skip entries of other directories. */
+		if ((dentries[i].dev != dip->dev) || (dentries[i].dir != dip->num))
+			continue;
+		
+		dentry_unhash(&dentries[i]);
+	}
+}
+
+/**
+ * @brief Initializes the directory cache.
+ */
+PUBLIC void dcache_init(void)
+{
+	kprintf("fs: initializing directory cache");
+	
+	lru.lru_next = &lru;
+	lru.lru_prev = &lru;
+	for (unsigned i = 0; i < NR_DENTRIES; i++)
+	{
+		dentries[i].dir = INODE_NULL;
+		dentries[i].hash_next = NULL;
+		dentries[i].lru_next = lru.lru_next;
+		dentries[i].lru_prev = &lru;
+		lru.lru_next->lru_prev = &dentries[i];
+		lru.lru_next = &dentries[i];
+	}
+	
+	for (unsigned i = 0; i < HASHTAB_SIZE; i++)
+		hashtab[i] = NULL;
+}
@@ -21,17 +21,362 @@
 #include <nanvix/const.h>
 #include <nanvix/fs.h>
 #include <nanvix/klib.h>
+#include <nanvix/mm.h>
 #include <sys/types.h>
 #include <dirent.h>
 #include <errno.h>
 #include "fs.h"
 
+/**
+ * @brief Number of hash buckets of a newly hashed directory.
+ */
+#define DINDEX_MIN 2
+
+/**
+ * @brief Number of directory entries in a block.
+ */
+#define DIRENTS_PER_BLOCK (BLOCK_SIZE/sizeof(struct d_dirent))
+
+/**
+ * @brief Gets the number of hash buckets of a directory.
+ * 
+ * @param dip Directory.
+ * 
+ * @returns The number of hash buckets of the directory pointed to by @p dip,
+ *          or zero if the directory is not hashed.
+ * 
+ * @note @p dip must be locked.
+ */
+PRIVATE unsigned dindex_get(struct inode *dip)
+{
+	unsigned n;         /* Number of buckets. */
+	struct buffer *buf; /* Block buffer.      */
+	struct d_dindex *x; /* Directory index.   */
+	
+	/* Too small to be hashed. */
+	if ((dip->size < 2*BLOCK_SIZE) || (dip->blocks[0] == BLOCK_NULL))
+		return (0);
+	
+	buf = bread(dip->dev, dip->blocks[0]);
+	x = &((struct d_dindex *)buf->data)[DINDEX_SLOT];
+	n = ((x->d_ino == INODE_NULL) && (x->d_magic == DINDEX_MAGIC)) ?
+		x->d_nbuckets : 0;
+	brelse(buf);
+	
+	/*
+	 * The directory has been expanded by someone
+	 * that does not know about the index, so
+	 * fallback to a linear search.
+	 */
+	if ((off_t)((n + 1)*BLOCK_SIZE) != dip->size)
+		return (0);
+	
+	return (n);
+}
+
+/**
+ * @brief Sets the number of hash buckets of a directory.
+ * 
+ * @param dip Directory.
+ * @param n   Number of buckets. Zero drops the index.
+ * 
+ * @note @p dip must be locked.
+ */
+PRIVATE void dindex_set(struct inode *dip, unsigned n)
+{
+	struct buffer *buf; /* Block buffer.    */
+	struct d_dindex *x; /* Directory index. */
+	
+	buf = bread(dip->dev, dip->blocks[0]);
+	x = &((struct d_dindex *)buf->data)[DINDEX_SLOT];
+	kmemset(x, 0, sizeof(struct d_dindex));
+	if (n > 0)
+	{
+		x->d_magic = DINDEX_MAGIC;
+		x->d_nbuckets = n;
+	}
+	buffer_dirty(buf, 1);
+	brelse(buf);
+}
+
+/**
+ * @brief Appends empty hash buckets to a directory.
+ * 
+ * @param dip   Directory.
+ * @param first First bucket.
+ * @param n     Number of buckets.
+ * 
+ * @returns Zero upon success, and non-zero otherwise.
+ * 
+ * @note @p dip must be locked.
+ */
+PRIVATE int dindex_alloc(struct inode *dip, unsigned first, unsigned n)
+{
+	block_t blk;        /* Working block. */
+	struct buffer *buf; /* Block buffer.  */
+	
+	for (unsigned i = first; i < first + n; i++)
+	{
+		blk = block_map(dip, (i + 1)*BLOCK_SIZE, 1);
+		
+		/* Failed to allocate bucket. */
+		if (blk == BLOCK_NULL)
+			return (-1);
+		
+		buf = bget(dip->dev, blk);
+		kmemset(buf->data, 0, BLOCK_SIZE);
+		buffer_dirty(buf, 1);
+		brelse(buf);
+	}
+	
+	dip->size = (first + n + 1)*BLOCK_SIZE;
+	inode_touch(dip);
+	
+	return (0);
+}
+
+/**
+ * @brief Moves directory entries of a block to a hash bucket.
+ * 
+ * @param dip  Directory.
+ * @param src  Buffer of source block.
+ * @param skip Number of slots to skip.
+ * @param n    Number of buckets.
+ * @param i    Target bucket.
+ * 
+ * @details Moves all directory entries of @p src, but the ones in the first
+ *          @p skip slots, that hash into the @p i-th bucket of a directory
+ *          that has @p n buckets.
+ * 
+ * @note @p dip must be locked.
+ */
+PRIVATE void dindex_move
+(struct inode *dip, struct buffer *src, unsigned skip, unsigned n, unsigned i)
+{
+	struct buffer *dst;     /* Target bucket.        */
+	struct d_dirent *s, *d; /* Working dir. entries. */
+	
+	dst = bread(dip->dev, block_map(dip, (i + 1)*BLOCK_SIZE, 0));
+	d = dst->data;
+	
+	s = (struct d_dirent *)src->data + skip;
+	for (unsigned j = skip; j < DIRENTS_PER_BLOCK; j++, s++)
+	{
+		if (s->d_ino == INODE_NULL)
+			continue;
+		if (dindex_hash(s->d_name)%n != i)
+			continue;
+		
+		kmemcpy(d++, s, sizeof(struct d_dirent));
+		s->d_ino = INODE_NULL;
+	}
+	
+	buffer_dirty(src, 1);
+	buffer_dirty(dst, 1);
+	brelse(dst);
+}
+
+/**
+ * @brief Hashes a directory.
+ * 
+ * @details Moves all directory entries of a full directory, but "." and ".."
+ *          into hash buckets.
+ * 
+ * @param dip Directory.
+ * 
+ * @returns Zero upon success, and non-zero otherwise.
+ * 
+ * @note @p dip must be locked.
+ */
+PRIVATE int dindex_build(struct inode *dip)
+{
+	struct buffer *buf; /* Block buffer. */
+	
+	if (dip->blocks[0] == BLOCK_NULL)
+		return (-1);
+	
+	if (dindex_alloc(dip, 0, DINDEX_MIN))
+		return (-1);
+	
+	buf = bread(dip->dev, dip->blocks[0]);
+	for (unsigned i = 0; i < DINDEX_MIN; i++)
+		dindex_move(dip, buf, DINDEX_SLOT, DINDEX_MIN, i);
+	brelse(buf);
+	
+	dindex_set(dip, DINDEX_MIN);
+	
+	return (0);
+}
+
+/**
+ * @brief Doubles the number of hash buckets of a directory.
+ * 
+ * @details Since a name that hashes into the i-th bucket of @p n buckets
+ *          hashes either into the i-th or into the (i + n)-th bucket of
+ *          2*n buckets, buckets are split one at a time, in place.
+ * 
+ * @param dip Directory.
+ * @param n   Current number of buckets.
+ * 
+ * @returns Zero upon success, and non-zero otherwise.
+ * 
+ * @note @p dip must be locked.
+ */
+PRIVATE int dindex_grow(struct inode *dip, unsigned n)
+{
+	block_t blk;        /* Working block. */
+	struct buffer *buf; /* Block buffer.  */
+	
+	if (dindex_alloc(dip, n, n))
+		return (-1);
+	
+	for (unsigned i = 0; i < n; i++)
+	{
+		blk = block_map(dip, (i + 1)*BLOCK_SIZE, 0);
+		
+		buf = bread(dip->dev, blk);
+		dindex_move(dip, buf, 0, 2*n, i + n);
+		brelse(buf);
+	}
+	
+	dindex_set(dip, 2*n);
+	
+	return (0);
+}
+
+/**
+ * @brief Searches for a directory entry in a block.
+ * 
+ * @param buf      Block buffer.
+ * @param filename Name of the directory entry that shall be searched.
+ * @param free     Place to store the first free directory entry.
+ * 
+ * @returns The directory entry named @p filename, or a #NULL pointer if such
+ *          entry does not exist in the block.
+ */
+PRIVATE struct d_dirent *dirent_scan
+(struct buffer *buf, const char *filename, struct d_dirent **free)
+{
+	struct d_dirent *d; /* Directory entry. */
+	
+	d = buf->data;
+	for (unsigned i = 0; i < DIRENTS_PER_BLOCK; i++, d++)
+	{
+		/* Remember free entry. */
+		if (d->d_ino == INODE_NULL)
+		{
+			if ((free != NULL) && (*free == NULL))
+				*free = d;
+			continue;
+		}
+		
+		/* Found. */
+		if (!kstrncmp(d->d_name, filename, NAME_MAX))
+			return (d);
+	}
+	
+	return (NULL);
+}
+
+/**
+ * @brief Searches for a directory entry in a hashed directory.
+ * 
+ * @param dip      Directory where the directory entry shall be searched.
+ * @param n        Number of hash buckets of the directory.
+ * @param filename Name of the directory entry that shall be searched.
+ * @param buf      Buffer where the directory entry is loaded.
+ * @param create   Create directory entry?
+ * @param d        Place to store the directory entry.
+ * 
+ * @returns Zero if the search was carried out, in which case the results are
+ *          as in dirent_search(). If the directory could not be grown and the
+ *          index was dropped, non-zero is returned instead.
+ * 
+ * @note @p dip must be locked.
+ */
+PRIVATE int dirent_hashed(struct inode *dip, unsigned n, const char *filename,
+                          struct buffer **buf, int create, struct d_dirent **d)
+{
+	block_t blk;           /* Bucket.               */
+	struct d_dirent *free; /* Free directory entry. */
+
+again:
+
+	/* "." and ".." live in the first block. */
+	(*buf) = bread(dip->dev, dip->blocks[0]);
+	if (((*d) = dirent_scan(*buf, filename, NULL)) != NULL)
+		goto found;
+	brelse(*buf);
+	
+	blk = block_map(dip, (dindex_hash(filename)%n + 1)*BLOCK_SIZE, 0);
+	
+	/* Failed to allocate bucket. */
+	if (blk == BLOCK_NULL)
+	{
+		(*buf) = NULL;
+		if (create)
+			curr_proc->errno = -ENOSPC;
+		return (0);
+	}
+	
+	free = NULL;
+	(*buf) = bread(dip->dev, blk);
+	if (((*d) = dirent_scan(*buf, filename, &free)) != NULL)
+		goto found;
+	
+	/* Create entry. */
+	if ((create) && (free != NULL))
+	{
+		(*d) = free;
+		return (0);
+	}
+	
+	brelse(*buf);
+	(*buf) = NULL;
+	
+	if (!create)
+		return (0);
+	
+	/* Bucket is full, so double the number of buckets. */
+	if (2*n <= DINDEX_MAX)
+	{
+		if (dindex_grow(dip, n))
+		{
+			curr_proc->errno = -ENOSPC;
+			return (0);
+		}
+		
+		n <<= 1;
+		goto again;
+	}
+	
+	/* Too many buckets, so fallback to a linear directory. */
+	dindex_set(dip, 0);
+	
+	return (-1);
+
+found:
+
+	/* Duplicated entry. */
+	if (create)
+	{
+		brelse(*buf);
+		(*buf) = NULL;
+		(*d) = NULL;
+		curr_proc->errno = EEXIST;
+	}
+	
+	return (0);
+}
+
 /**
  * @brief Searches for a directory entry.
  * 
  * @details Searches for a directory entry named @p filename in the directory
  *          pointed to be @p dip. If @p create is not zero and such file entry
- *          does not exist, the entry is created.
+ *          does not exist, the entry is created. Once a directory outgrows
+ *          its first block, it is hashed, and only the bucket where
+ *          @p filename hashes to is searched.
  * 
  * @param dip      Directory where the directory entry shall be searched.
  * @param filename Name of the directory entry that shall be searched.
@@ -55,6 +400,13 @@ PRIVATE struct d_dirent *dirent_search
 	block_t blk;        /* Working block number.                */
 	int nentries;       /* Number of directory entries.         */
 	struct d_dirent *d; /* Directory entry.                     */
+	unsigned n;         /* Number of hash buckets.              */
+	
+	n = dindex_get(dip);
+	
+	/* Hashed directory. */
+	if ((n > 0) && (!dirent_hashed(dip, n, filename, buf, create, &d)))
+		return (d);
 	
 	nentries = dip->size/sizeof(struct d_dirent);
 	
@@ -133,6 +485,10 @@ PRIVATE struct d_dirent *dirent_search
 		/* Expand directory. */
 		if (entry < 0)
 		{
+			/* Directory is getting large, so hash it. */
+			if ((dip->size == BLOCK_SIZE) && (!dindex_build(dip)))
+				return (dirent_search(dip, filename, buf, create));
+			
 			entry = nentries;
 			
 			blk = block_map(dip, entry*sizeof(struct d_dirent), 1);
@@ -179,17 +535,27 @@ PRIVATE struct d_dirent *dirent_search
  */
 PUBLIC ino_t dir_search(struct inode *ip, const char *filename)
 {
+	ino_t num;          /* Inode number.    */
 	struct buffer *buf; /* Block buffer.    */
 	struct d_dirent *d; /* Directory entry. */
 	
+	/* Directory cache hit. */
+	if (!dcache_lookup(ip, filename, &num))
+		return (num);
+	
 	/* Search directory entry. */
 	d = dirent_search(ip, filename, &buf, 0);
 	if (d == NULL)
-		return (INODE_NULL);
+		num = INODE_NULL;
+	else
+	{
+		num = d->d_ino;
+		brelse(buf);
+	}
 	
-	brelse(buf);
+	dcache_insert(ip, filename, num);
 	
-	return (d->d_ino);
+	return (num);
 }
 
 /*
@@ -245,7 +611,8 @@ PUBLIC int dir_remove(struct inode *dinode, const char *filename)
 	
 	/* Remove directory entry. */
 	d->d_ino = INODE_NULL;
-	buf->flags |= BUFFER_DIRTY;
+	buffer_dirty(buf, 1);
+	dcache_insert(dinode, filename, INODE_NULL);
 	inode_touch(dinode);
 	file->nlinks--;
 	inode_touch(file);
@@ -271,27 +638,109 @@ PUBLIC int dir_add(struct inode *dinode, struct inode *inode, const char *name)
 	
 	kstrncpy(d->d_name, name, NAME_MAX);
 	d->d_ino = inode->num;
-	buf->flags |= BUFFER_DIRTY;
+	buffer_dirty(buf, 1);
 	brelse(buf);
+	dcache_insert(dinode, name, inode->num);
 	
 	return (0);
 }
 
+/*
+ * Starts reading asynchronously the blocks of a regular file in a range.
+ * Blocks that are consecutive on disk are read ahead in runs.
+ */
+PRIVATE void file_readahead(struct inode *i, off_t start, off_t end)
+{
+	block_t blk;   /* Working block number. */
+	block_t first; /* First block of run.   */
+	unsigned n;    /* Blocks in run.        */
+	
+	/* Do not read past the end of file. */
+	if (end > i->size)
+		end = i->size;
+	
+	first = BLOCK_NULL;
+	n = 0;
+	
+	for (start &= ~(BLOCK_SIZE - 1); start < end; start += BLOCK_SIZE)
+	{
+		blk = block_map(i, start, 0);
+		
+		/* Extend run. */
+		if ((n > 0) && (n < READAHEAD_MAX) && (blk == first + n))
+		{
+			n++;
+			continue;
+		}
+		
+		if (n > 0)
+			breada(i->dev, first, n);
+		
+		first = blk;
+		n = (blk != BLOCK_NULL) ? 1 : 0;
+	}
+	
+	if (n > 0)
+		breada(i->dev, first, n);
+}
+
 /*
  * Reads from a regular file.
+ * 
+ * If ra is not a null pointer, the file is read ahead when it is
+ * accessed sequentially. The read-ahead window grows on every sequential
+ * read and shrinks on random reads.
  */
-PUBLIC ssize_t file_read(struct inode *i, void *buf, size_t n, off_t off)
+PUBLIC ssize_t file_read(struct inode *i, void *buf, size_t n, off_t off,
+                         struct readahead *ra)
 {
 	char *p;             /* Writing pointer.      */
 	size_t blkoff;       /* Block offset.         */
 	size_t chunk;        /* Data chunk size.      */
 	block_t blk;         /* Working block number. */
 	struct buffer *bbuf; /* Working block buffer. */
+	off_t start, end;    /* Range to read ahead.  */
 		
 	p = buf;
 	
 	inode_lock(i);
 	
+	start = off;
+	end = off + n;
+	
+	if (ra != NULL)
+	{
+		/* Sequential access. */
+		if (off == ra->next)
+		{
+			if (ra->window == 0)
+				ra->window = READAHEAD_MIN;
+			else if (ra->window < READAHEAD_MAX)
+				ra->window <<= 1;
+			
+			end += ra->window << BLOCK_SIZE_LOG2;
+			
+			/* Skip what has already been read ahead. */
+			if (ra->ahead > start)
+				start = ra->ahead;
+			if (ra->ahead < end)
+				ra->ahead = end;
+		}
+		
+		/* Random access. */
+		else
+		{
+			ra->window >>= 1;
+			ra->ahead = end;
+		}
+	}
+	
+	/*
+	 * Issue all reads at once, so that the
+	 * underlying device may merge them.
+	 */
+	file_readahead(i, start, end);
+	
 	/* Read data. */
 	do
 	{
@@ -326,6 +775,8 @@ PUBLIC ssize_t file_read(struct inode *i, void *buf, size_t n, off_t off)
 	} while (n > 0);
 
 out:
+	if (ra != NULL)
+		ra->next = off;
 	inode_touch(i);
 	inode_unlock(i);
 	return ((ssize_t)(p - (char *)buf));
@@ -346,6 +797,9 @@ PUBLIC ssize_t file_write(struct inode *i, const void *buf, size_t n, off_t off)
 	
 	inode_lock(i);
 	
+	/* Cached pages become stale. */
+	purgepg(i);
+	
 	/* Write data. */
 	do
 	{
@@ -355,13 +809,18 @@ PUBLIC ssize_t file_write(struct inode *i, const void *buf, size_t n, off_t off)
 		if (blk == BLOCK_NULL)
 			goto out;
 		
-		bbuf = bread(i->dev, blk);
-		
 		blkoff = off % BLOCK_SIZE;
 		
 		chunk = (n < BLOCK_SIZE - blkoff) ? n : BLOCK_SIZE - blkoff;
-		kmemcpy((char *)bbuf->data + blkoff, buf, chunk);
-		bbuf->flags |= BUFFER_DIRTY;
+		
+		/* Whole block is overwritten, so do not read it. */
+		if (chunk == BLOCK_SIZE)
+			bbuf = bget(i->dev, blk);
+		else
+			bbuf = bread(i->dev, blk);
+		
+		kmemcpy((char *)bbuf->data + blkoff, p, chunk);
+		buffer_dirty(bbuf, 1);
 		brelse(bbuf);
 		
 		n -= chunk;
@@ -137,42 +137,34 @@ PUBLIC mode_t permission(mode_t mode, uid_t uid, gid_t gid, struct process *proc
  */
 PUBLIC char *getname(const char *name)
 {
-	int ch;        /* Temporary character. */
-	char *kname;   /* Kernel user name.    */
-	const char *r; /* Read pointer.        */
-	char *w;       /* Write pointer.       */
+	ssize_t len; /* File name length. */
+	char *kname; /* Kernel user name. */
 	
-	/* Grab a kernel page. */
-	if ((kname = getkpg(0)) == NULL)
+	/* Grab a kernel buffer. */
+	if ((kname = kmalloc(PATH_MAX)) == NULL)
 	{
 		curr_proc->errno = -ENOMEM;
 		return (NULL);
 	}
 
 	/* Copy user file name. */
-	for (r = name, w = kname; (ch = fubyte(r)) != '\0'; r++, w++)
-	{	
-		/* Bad user file name. */
-		if (ch < 0)
-		{
-			putkpg(kname);
-			curr_proc->errno = -EFAULT;
-			return (NULL);
-			
-		}
-		
-		/* File name too long. */
-		if ((w - kname) > PAGE_SIZE - 1)
-		{
-			putkpg(kname);
-			curr_proc->errno = -ENAMETOOLONG;
-			return (NULL);
-		}
-		
-		*w = ch;
+	len = strncpy_from_user(kname, name, PATH_MAX);
+	
+	/* Bad user file name. */
+	if (len < 0)
+	{
+		kfree(kname);
+		curr_proc->errno = len;
+		return (NULL);
+	}
+	
+	/* File name too long. */
+	if (len >= PATH_MAX)
+	{
+		kfree(kname);
+		curr_proc->errno = -ENAMETOOLONG;
+		return (NULL);
 	}
-
-	*w = '\0';
 	
 	return (kname);
 }
@@ -182,7 +174,7 @@ PUBLIC char *getname(const char *name)
  */
 PUBLIC void putname(char *name)
 {
-	putkpg(name);
+	kfree(name);
 }
 
 /*
@@ -192,6 +184,7 @@ PUBLIC void fs_init(void)
 {
 	binit();
 	inode_init();
+	dcache_init();
 	superblock_init();
 	
 	/* Sanity check. */
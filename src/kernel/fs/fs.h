@@ -48,7 +48,8 @@
 		BUFFER_DIRTY  = (1 << 0), /**< Dirty?             */
 		BUFFER_VALID  = (1 << 1), /**< Valid?             */
 		BUFFER_LOCKED = (1 << 2), /**< Locked?            */
-		BUFFER_SYNC   = (1 << 3)  /**< Synchronous write? */
+		BUFFER_SYNC   = (1 << 3), /**< Synchronous write? */
+		BUFFER_ASYNC  = (1 << 4)  /**< Asynchronous read? */
 	};
 
 	/**
@@ -63,6 +64,7 @@
 		dev_t dev;      /**< Device.          */
 		block_t num;    /**< Block number.    */
 		void *data;     /**< Underlying data. */
+		void *mem;      /**< Own memory.      */
 		unsigned count; /**< Reference count. */
 		/**@}*/
 		
@@ -70,8 +72,9 @@
 		 * @name Status information
 		 */
 		/**@{*/
-		enum buffer_flags flags; /**< Flags.          */
-		struct process *chain;   /**< Sleeping chain. */
+		enum buffer_flags flags; /**< Flags.                    */
+		struct process *chain;   /**< Sleeping chain.           */
+		unsigned dirtied;        /**< When buffer became dirty. */
 		/**@}*/
 		
 		/**
@@ -82,6 +85,7 @@
 		struct buffer *free_prev; /**< Previous buffer in the free list.  */
 		struct buffer *hash_next; /**< Next buffer in the hash table.     */
 		struct buffer *hash_prev; /**< Previous buffer in the hash table. */
+		int queue;                /**< Replacement queue.                 */
 		/**@}*/
 	};
 	
@@ -97,6 +101,16 @@
 	/* Forward definitions. */
 	EXTERN void inode_init(void);
 
+/*============================================================================*
+ *                          Directory Cache Library                           *
+ *============================================================================*/
+	
+	/* Forward definitions. */
+	EXTERN void dcache_init(void);
+	EXTERN int dcache_lookup(struct inode *, const char *, ino_t *);
+	EXTERN void dcache_insert(struct inode *, const char *, ino_t);
+	EXTERN void dcache_purge(struct inode *);
+
 /*============================================================================*
  *                            Super Block Library                             *
  *============================================================================*/
@@ -139,6 +153,10 @@
 		block_t imap_blocks;            /**< Number of inode map blocks.   */
 		struct buffer *zmap[ZMAP_SIZE]; /**< Zone map.                     */
 		block_t zmap_blocks;            /**< Number of zone map blocks.    */
+		
+		/** Zones reserved for preallocation windows. Kept in-core only. */
+		uint32_t rmap[ZMAP_SIZE][BLOCK_SIZE >> 2];
+		
 		block_t first_data_block;       /**< First data block.             */
 		off_t max_size;                 /**< Maximum file size.            */
 		block_t zones;                  /**< Number of zones.              */
@@ -277,11 +277,14 @@ PRIVATE void inode_free(struct inode *ip)
 	
 	blk = (ip->num - 1)/(BLOCK_SIZE << 3);
 	
+	/* Names in a removed directory are gone. */
+	dcache_purge(ip);
+	
 	superblock_lock(sb = ip->sb);
 	
 	bitmap_clear(sb->imap[blk]->data, (ip->num - 1)%(BLOCK_SIZE << 3));
 	
-	sb->imap[blk]->flags |= BUFFER_DIRTY;
+	buffer_dirty(sb->imap[blk], 1);
 	if (ip->num < sb->isearch)
 		sb->isearch = ip->num;
 	sb->flags |= SUPERBLOCK_DIRTY;
@@ -354,6 +357,9 @@ PUBLIC void inode_truncate(struct inode *ip)
 {
 	struct superblock *sb;
 	
+	/* Cached pages become stale. */
+	purgepg(ip);
+	
 	superblock_lock(sb = ip->sb);
 	
 	/* Free direct zone. */
@@ -437,7 +443,7 @@ found:
 	
 	/* Allocate inode. */
 	bitmap_set(sb->imap[i]->data, bit);
-	sb->imap[i]->flags |= BUFFER_DIRTY;
+	buffer_dirty(sb->imap[i], 1);
 	sb->flags |= SUPERBLOCK_DIRTY;
 	
 	/* 
@@ -613,6 +619,9 @@ PUBLIC void inode_put(struct inode *ip)
 		/* File inode. */
 		else
 		{		
+			/* Release preallocated disk blocks. */
+			block_release(ip);
+			
 			/* Free underlying disk blocks. */
 			if (ip->nlinks == 0)
 			{
@@ -303,6 +303,7 @@ PUBLIC struct superblock *superblock_read(dev_t dev)
 	sb->zmap_blocks = d_sb->s_bmap_nblocks;
 	for (unsigned i = 0; i < sb->zmap_blocks; i++)
 		blkunlock(sb->zmap[i] = bread(dev, 2 + sb->imap_blocks + i));
+	kmemset(sb->rmap, 0, sizeof(sb->rmap));
 	sb->first_data_block = d_sb->s_first_data_block;
 	sb->max_size = d_sb->s_max_size;
 	sb->zones = d_sb->s_nblocks;
@@ -134,6 +134,18 @@ PUBLIC void kmain(void)
 		_exit(-1);
 	}
 	
+	/* Spawn block buffer cache flusher. */
+	if ((pid = fork()) < 0)
+		kpanic("failed to fork flusher daemon");
+	else if (pid == 0)
+		bflushd();
+	
+	/* Spawn page-out daemon. */
+	if ((pid = fork()) < 0)
+		kpanic("failed to fork page-out daemon");
+	else if (pid == 0)
+		kswapd();
+	
 	/* idle process. */	
 	while (1)
 	{
@@ -17,28 +17,57 @@
  * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <i386/i386.h>
 #include <nanvix/const.h>
 #include <sys/types.h>
 
 /**
  * @brief Copy bytes in memory.
  * 
+ * @details Copies the bulk of the memory area in dwords, with the write
+ *          pointer aligned on a dword boundary, and the remaining bytes one
+ *          by one.
+ * 
  * @param dest Target memory area.
  * @param src  Source memory area.
  * @param n    Number of bytes to be copied.
  * 
  * @returns A pointer to the target memory area.
  */
-PUBLIC void *kmemcpy (void* dest, const void *src, size_t n)
+PUBLIC void *kmemcpy(void *dest, const void *src, size_t n)
 {
-    char *d;       /* Write pointer. */
-    const char* s; /* Read pointer.  */
-    
-    s = src;
-    d = dest;
-    
-    while (n-- > 0)
-    	*d++ = *s++;
- 
-    return (d);
+	char *d;       /* Write pointer.    */
+	const char *s; /* Read pointer.     */
+	size_t count;  /* Number of dwords. */
+	
+	s = src;
+	d = dest;
+	
+	/* Copy dwords. */
+	if (n >= 8*sizeof(dword_t))
+	{
+		/* Align write pointer. */
+		while ((unsigned)d & (sizeof(dword_t) - 1))
+		{
+			*d++ = *s++;
+			n--;
+		}
+		
+		count = n/sizeof(dword_t);
+		n &= sizeof(dword_t) - 1;
+		
+		__asm__ volatile (
+			"cld\n"
+			"rep movsl"
+			: "+D" (d), "+S" (s), "+c" (count)
+			:
+			: "memory"
+		);
+	}
+	
+	/* Copy remaining bytes. */
+	while (n-- > 0)
+		*d++ = *s++;
+	
+	return (dest);
 }
@@ -17,12 +17,16 @@
  * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <i386/i386.h>
 #include <nanvix/const.h>
 #include <sys/types.h>
 
 /**
  * @brief Sets bytes in memory.
  * 
+ * @details Sets the bulk of the memory area in dwords, with the write pointer
+ *          aligned on a dword boundary, and the remaining bytes one by one.
+ * 
  * @param ptr Pointer to target memory area.
  * @param c   Character to use.
  * @param n   Number of bytes to be set.
@@ -31,13 +35,41 @@
  */
 PUBLIC void *kmemset(void *ptr, int c, size_t n)
 {
-    unsigned char *p;
-    
-    p = ptr;
-    
-    /* Set bytes. */
-    while (n-- > 0)
+	unsigned char *p; /* Write pointer.    */
+	dword_t pattern;  /* Fill pattern.     */
+	size_t count;     /* Number of dwords. */
+	
+	p = ptr;
+	
+	/* Set dwords. */
+	if (n >= 8*sizeof(dword_t))
+	{
+		/* Align write pointer. */
+		while ((unsigned)p & (sizeof(dword_t) - 1))
+		{
+			*p++ = (unsigned char) c;
+			n--;
+		}
+		
+		pattern = (unsigned char) c;
+		pattern |= pattern << 8;
+		pattern |= pattern << 16;
+		
+		count = n/sizeof(dword_t);
+		n &= sizeof(dword_t) - 1;
+		
+		__asm__ volatile (
+			"cld\n"
+			"rep stosl"
+			: "+D" (p), "+c" (count)
+			: "a" (pattern)
+			: "memory"
+		);
+	}
+	
+	/* Set remaining bytes. */
+	while (n-- > 0)
 		*p++ = (unsigned char) c;
 
-    return (ptr);	
+	return (ptr);
 }
@@ -0,0 +1,68 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <i386/i386.h>
+#include <i386/paging.h>
+#include <nanvix/const.h>
+#include <sys/types.h>
+
+/**
+ * @brief Copies a page.
+ * 
+ * @param dest Target page.
+ * @param src  Source page.
+ * 
+ * @note Both pages must be page aligned.
+ */
+PUBLIC void kpage_copy(void *dest, const void *src)
+{
+	size_t count; /* Number of dwords. */
+	
+	count = PAGE_SIZE/sizeof(dword_t);
+	
+	__asm__ volatile (
+		"cld\n"
+		"rep movsl"
+		: "+D" (dest), "+S" (src), "+c" (count)
+		:
+		: "memory"
+	);
+}
+
+/**
+ * @brief Zeroes a page.
+ * 
+ * @param pg Target page.
+ * 
+ * @note The page must be page aligned.
+ */
+PUBLIC void kpage_zero(void *pg)
+{
+	size_t count; /* Number of dwords. */
+	
+	count = PAGE_SIZE/sizeof(dword_t);
+	
+	__asm__ volatile (
+		"cld\n"
+		"rep stosl"
+		: "+D" (pg), "+c" (count)
+		: "a" (0)
+		: "memory"
+	);
+}
@@ -22,6 +22,8 @@
 #include <nanvix/region.h>
 #include <nanvix/klib.h>
 #include <nanvix/mm.h>
+#include <errno.h>
+#include "mm.h"
 
 /*
  * Bad KPOOL_PHYS ?
@@ -71,6 +73,8 @@
  */
 PUBLIC void mm_init(void)
 {
+	initpg();
+	initslab();
 	initreg();
 }
 
@@ -111,63 +115,137 @@ PUBLIC int chkmem(const void *addr, size_t size, mode_t mask)
 }
 
 /**
- * @brief Fetches a byte from user address space.
+ * @brief Checks access permissions to a user memory area.
  * 
- * @param addr Address where the byte should be fetched.
+ * @param addr Start address of the memory area.
+ * @param n    Size of the memory area.
+ * @param mask Access permissions mask.
  * 
- * @returns Upon successful completion the byte fetched is returned 
- *          (casted to int). Upon failure, -1 is returned instead. 
+ * @returns The number of bytes, starting at @p addr and up to @p n, that lie
+ *          in the same process region and that may be accessed, or zero if
+ *          @p addr may not be accessed at all.
  */
-PUBLIC int fubyte(const void *addr)
-{	
-	int byte;            /* User byte.               */
+PRIVATE size_t chkuser(const void *addr, size_t n, mode_t mask)
+{
+	addr_t end;           /* End of region.          */
+	struct region *reg;   /* Working memory region.  */
 	struct pregion *preg; /* Working process region. */
 	
 	/* Kernel address space. */
-	if (((addr_t)addr < UBASE_VIRT) || ((addr_t)addr >= KBASE_VIRT))
+	if ((ADDR(addr) < UBASE_VIRT) || (ADDR(addr) >= KBASE_VIRT))
+		return ((KERNEL_RUNNING(curr_proc)) ? n : 0);
+	
+	/* Get associated process region. */
+	if ((preg = findreg(curr_proc, ADDR(addr))) == NULL)
+		return (0);
+	
+	lockreg(reg = preg->reg);
+	
+	/* Not allowed. */
+	if (!(accessreg(curr_proc, reg) & mask) || !withinreg(preg, ADDR(addr)))
 	{
-		if (KERNEL_RUNNING(curr_proc))
-			return (*((char *)addr));
-		
-		return (-1);
+		unlockreg(reg);
+		return (0);
 	}
 	
-	/* Get associated process region. */
-	if ((preg = findreg(curr_proc, (addr_t)addr)) == NULL)
-		return (-1);
+	end = (reg->flags & REGION_DOWNWARDS) ?
+		preg->start : preg->start + reg->size;
 	
-	byte = (withinreg(preg, ADDR(addr))) ? (*((char *)addr)) : -1;
+	unlockreg(reg);
 	
-	return (byte);
+	return ((end - ADDR(addr) < n) ? end - ADDR(addr) : n);
 }
 
 /**
- * @brief Fetches a double word (4 bytes) from user address space.
+ * @brief Copies data from user address space.
  * 
- * @param addr Address where the byte should be fetched.
+ * @param to   Target kernel buffer.
+ * @param from Source user buffer.
+ * @param n    Number of bytes to copy.
  * 
- * @returns Upon successful completion the byte fetched is returned (casted to
- *          int). Upon failure, -1 is returned instead.
+ * @returns Upon successful completion, zero is returned. Upon failure, a
+ *          negative error code is returned instead.
  */
-PUBLIC int fudword(const void *addr)
-{	
-	int dword;            /* User double word.       */
-	struct pregion *preg; /* Working process region. */
+PUBLIC int copy_from_user(void *to, const void *from, size_t n)
+{
+	size_t chunk; /* Bytes to copy at once. */
 	
-	/* Kernel address space. */
-	if (((addr_t)addr < UBASE_VIRT) || ((addr_t)addr >= KBASE_VIRT))
+	while (n > 0)
 	{
-		if (KERNEL_RUNNING(curr_proc))
-			return (*((int *)addr));
+		/* Bad user buffer. */
+		if ((chunk = chkuser(from, n, MAY_READ)) == 0)
+			return (-EFAULT);
 		
-		return (-1);
+		kmemcpy(to, from, chunk);
+		
+		to = (char *)to + chunk;
+		from = (const char *)from + chunk;
+		n -= chunk;
 	}
 	
-	/* Get associated process region. */
-	if ((preg = findreg(curr_proc, (addr_t)addr)) == NULL)
-		return (-1);
+	return (0);
+}
+
+/**
+ * @brief Copies data to user address space.
+ * 
+ * @param to   Target user buffer.
+ * @param from Source kernel buffer.
+ * @param n    Number of bytes to copy.
+ * 
+ * @returns Upon successful completion, zero is returned. Upon failure, a
+ *          negative error code is returned instead.
+ */
+PUBLIC int copy_to_user(void *to, const void *from, size_t n)
+{
+	size_t chunk; /* Bytes to copy at once. */
+	
+	while (n > 0)
+	{
+		/* Bad user buffer. */
+		if ((chunk = chkuser(to, n, MAY_WRITE)) == 0)
+			return (-EFAULT);
+		
+		kmemcpy(to, from, chunk);
+		
+		to = (char *)to + chunk;
+		from = (const char *)from + chunk;
+		n -= chunk;
+	}
 	
-	dword = (withinreg(preg, ADDR(addr))) ? (*((int *)addr)) : -1;
+	return (0);
+}
+
+/**
+ * @brief Copies a string from user address space.
+ * 
+ * @param to   Target kernel buffer.
+ * @param from Source user string.
+ * @param n    Size of target kernel buffer.
+ * 
+ * @returns Upon successful completion, the length of the copied string is
+ *          returned. If the string does not fit in @p n bytes, @p n is
+ *          returned, and @p to is not null terminated. Upon failure, a
+ *          negative error code is returned instead.
+ */
+PUBLIC ssize_t strncpy_from_user(char *to, const char *from, size_t n)
+{
+	size_t len;   /* String length.         */
+	size_t chunk; /* Bytes to copy at once. */
+	
+	for (len = 0; len < n; /* noop. */)
+	{
+		/* Bad user string. */
+		if ((chunk = chkuser(from + len, n - len, MAY_READ)) == 0)
+			return (-EFAULT);
+		
+		while (chunk-- > 0)
+		{
+			if ((to[len] = from[len]) == '\0')
+				return (len);
+			len++;
+		}
+	}
 	
-	return (dword);
+	return (len);
 }
@@ -20,15 +20,25 @@
 #ifndef _MM_H_
 #define _MM_H_
 
+	/* Number of kernel pages. */
+	#define NR_KPAGES (KPOOL_SIZE/PAGE_SIZE)
+	
 	/* Page marks. */
 	#define PAGE_FILL 0 /* Demand fill. */
 	#define PAGE_ZERO 1 /* Demand zero. */
 	
 	/* Forward definitions. */
+	EXTERN void freepgtab(struct pte *);
 	EXTERN void freeupg(struct pte *);
-	EXTERN void linkupg(struct pte *, struct pte *);
+	EXTERN void initpg(void);
+	EXTERN void initslab(void);
+	EXTERN struct pte *linkpgtab(struct pte *);
+	EXTERN int linkupg(struct pte *, struct pte *);
 	EXTERN void mappgtab(struct process *, addr_t, void *);
+	EXTERN int sharedpgtab(struct process *, struct pte *, addr_t);
 	EXTERN void markpg(struct pte *, int);
 	EXTERN void umappgtab(struct process *, addr_t);
+	EXTERN int unsharepgtab
+		(struct process *, struct region *, unsigned, addr_t);
 
 #endif /* _MM_H_ */
@@ -36,6 +36,9 @@
 	#error "swapping area to small"
 #endif
 
+/* Forward definitions. */
+PRIVATE int allocf(void);
+
 /**
  * @brief Gets a page directory entry of a process.
  * 
@@ -59,18 +62,424 @@
 	(&((struct pte *)((getpde(p, a)->frame << PAGE_SHIFT) + KBASE_VIRT))[PG(a)])
 
 
+/*============================================================================*
+ *                               Page Frames                                  *
+ *============================================================================*/
+
+/* Number of page frames. */
+#define NR_FRAMES (UMEM_SIZE/PAGE_SIZE)
+
+/* Number of extra reverse mapping entries. */
+#define NR_RMAPS NR_FRAMES
+
+/**
+ * @brief Gets the page table frame number of a user page frame.
+ * 
+ * @param i Index of the page frame.
+ */
+#define FRAME_NUM(i) \
+	((UBASE_PHYS >> PAGE_SHIFT) + (i))
+
+/**
+ * @brief Gets the physical address of a user page frame.
+ * 
+ * @param i Index of the page frame.
+ */
+#define FRAME_PHYS(i) \
+	(UBASE_PHYS + ((i) << PAGE_SHIFT))
+
+/**
+ * @brief Reverse mapping entry.
+ */
+struct rmap
+{
+	struct pte *pte;   /**< Page table entry. */
+	struct rmap *next; /**< Next entry.       */
+};
+
+/**
+ * @brief Extra reverse mapping entries.
+ */
+PRIVATE struct rmap rmaps[NR_RMAPS];
+
+/**
+ * @brief Free reverse mapping entries.
+ */
+PRIVATE struct rmap *free_rmaps = NULL;
+
+/**
+ * @brief Page frames.
+ * 
+ * @details Each page frame knows the page table entries that map it (reverse
+ *          map), so that any page may be chosen for replacement. The first
+ *          page table entry is kept in the page frame itself, and entries of
+ *          shared page frames are chained in extra reverse mapping entries.
+ */
+PRIVATE struct
+{
+	unsigned count;    /**< Reference count.          */
+	unsigned locked;   /**< Lock count.               */
+	struct pte *pte;   /**< Page table entry.         */
+	struct rmap *rmap; /**< Other page table entries. */
+	unsigned blk;      /**< Cached swap block.        */
+	dev_t dev;         /**< Cached file device.       */
+	ino_t num;         /**< Cached file inode number. */
+	off_t off;         /**< Cached file offset.       */
+	int hnext;         /**< Next frame in hash chain. */
+	int prev;          /**< Previous cached frame.    */
+	int next;          /**< Next listed frame.        */
+} frames[NR_FRAMES];
+
+/**
+ * @brief Free page frames.
+ */
+PRIVATE int free_frames = -1;
+
+/**
+ * @brief Number of free and cached page frames.
+ */
+PRIVATE unsigned nfree = 0;
+
+/**
+ * @brief Page-out daemon sleeping chain.
+ */
+PRIVATE struct process *kswapd_chain = NULL;
+
+/**
+ * @brief Clock hand for page replacement.
+ */
+PRIVATE unsigned hand = 0;
+
+/**
+ * @brief Shared page frames paged out.
+ */
+PRIVATE unsigned nshared_out = 0;
+
+/**
+ * @brief Cached page frames.
+ * 
+ * @details Page frames that are mapped by no page but still hold a copy of a
+ *          swap block or of a file page, from the least to the most recently
+ *          cached. They count as free page frames, and are taken over by the
+ *          page frame allocator when the free list runs out.
+ */
+PRIVATE int cache_head = -1; /* Least recently cached. */
+PRIVATE int cache_tail = -1; /* Most recently cached.  */
+
+/**
+ * @brief Puts an unused page frame in the cached list.
+ * 
+ * @param i Index of the page frame.
+ */
+PRIVATE void cache_link(unsigned i)
+{
+	frames[i].count = 0;
+	frames[i].prev = cache_tail;
+	frames[i].next = -1;
+	
+	if (cache_tail >= 0)
+		frames[cache_tail].next = i;
+	else
+		cache_head = i;
+	cache_tail = i;
+	
+	nfree++;
+}
+
+/**
+ * @brief Removes a page frame from the cached list.
+ * 
+ * @param i Index of the page frame.
+ */
+PRIVATE void cache_unlink(unsigned i)
+{
+	if (frames[i].prev >= 0)
+		frames[frames[i].prev].next = frames[i].next;
+	else
+		cache_head = frames[i].next;
+	
+	if (frames[i].next >= 0)
+		frames[frames[i].next].prev = frames[i].prev;
+	else
+		cache_tail = frames[i].prev;
+	
+	nfree--;
+}
+
+/*
+ * Page cache hash table size.
+ */
+#define PCACHE_HASHTAB_SIZE 64
+
+/**
+ * @brief Hash function for the page cache.
+ * 
+ * @param dev File device.
+ * @param num File inode number.
+ */
+#define PCACHE_HASH(dev, num) \
+	(((dev)^(num))%PCACHE_HASHTAB_SIZE)
+
+/**
+ * @brief Page cache.
+ * 
+ * @details Page frames that hold read-only pages of files, so that all
+ *          processes that map the same file page share one page frame. Pages
+ *          of a file are hashed together, so that they can be purged at once.
+ */
+PRIVATE int pcache[PCACHE_HASHTAB_SIZE];
+
+/**
+ * @brief Searches the page cache.
+ * 
+ * @param ip  File inode.
+ * @param off File offset.
+ * 
+ * @returns If the file page is cached, the index of the page frame that holds
+ *          it is returned. Otherwise, a negative number is returned instead.
+ */
+PRIVATE int pcache_lookup(struct inode *ip, off_t off)
+{
+	int i;
+	
+	i = pcache[PCACHE_HASH(ip->dev, ip->num)];
+	for (/* noop */; i >= 0; i = frames[i].hnext)
+	{
+		if ((frames[i].dev == ip->dev) && (frames[i].num == ip->num))
+		{
+			if (frames[i].off == off)
+				return (i);
+		}
+	}
+	
+	return (-1);
+}
+
+/**
+ * @brief Inserts a page frame in the page cache.
+ * 
+ * @param i   Index of the page frame.
+ * @param ip  File inode.
+ * @param off File offset.
+ */
+PRIVATE void pcache_insert(unsigned i, struct inode *ip, off_t off)
+{
+	unsigned h;
+	
+	h = PCACHE_HASH(ip->dev, ip->num);
+	
+	frames[i].dev = ip->dev;
+	frames[i].num = ip->num;
+	frames[i].off = off;
+	frames[i].hnext = pcache[h];
+	pcache[h] = i;
+}
+
+/**
+ * @brief Removes a page frame from the page cache.
+ * 
+ * @param i Index of the page frame.
+ */
+PRIVATE void pcache_remove(unsigned i)
+{
+	int *p;
+	
+	p = &pcache[PCACHE_HASH(frames[i].dev, frames[i].num)];
+	while (*p != (int)i)
+		p = &frames[*p].hnext;
+	*p = frames[i].hnext;
+	
+	frames[i].num = 0;
+}
+
+/**
+ * @brief Releases a page frame.
+ * 
+ * @param i Index of the page frame.
+ */
+PRIVATE void freef(unsigned i)
+{
+	/* Forget file page. */
+	if (frames[i].num != 0)
+		pcache_remove(i);
+	
+	frames[i].count = 0;
+	frames[i].next = free_frames;
+	free_frames = i;
+	nfree++;
+}
+
+/**
+ * @brief Takes a page frame for use.
+ * 
+ * @param i Index of the page frame.
+ */
+PRIVATE void takef(unsigned i)
+{
+	frames[i].count = 1;
+	frames[i].locked = 0;
+	frames[i].pte = NULL;
+	frames[i].rmap = NULL;
+}
+
+/**
+ * @brief Adds a page table entry to the reverse map of a page frame.
+ * 
+ * @param i  Index of the page frame.
+ * @param pg Page table entry that maps the page frame.
+ * 
+ * @returns Zero upon success, and non-zero otherwise.
+ */
+PRIVATE int rmap_add(unsigned i, struct pte *pg)
+{
+	struct rmap *r;
+	
+	/* First page table entry. */
+	if (frames[i].pte == NULL)
+	{
+		frames[i].pte = pg;
+		return (0);
+	}
+	
+	/* Reverse map overflow. */
+	if ((r = free_rmaps) == NULL)
+	{
+		kprintf("mm: reverse map overflow");
+		return (-1);
+	}
+	
+	free_rmaps = r->next;
+	r->pte = pg;
+	r->next = frames[i].rmap;
+	frames[i].rmap = r;
+	
+	return (0);
+}
+
+/**
+ * @brief Removes a page table entry from the reverse map of a page frame.
+ * 
+ * @param i  Index of the page frame.
+ * @param pg Page table entry that no longer maps the page frame.
+ */
+PRIVATE void rmap_remove(unsigned i, struct pte *pg)
+{
+	struct rmap *r, **p;
+	
+	/* Promote an extra entry. */
+	if (frames[i].pte == pg)
+	{
+		frames[i].pte = NULL;
+		
+		if ((r = frames[i].rmap) != NULL)
+		{
+			frames[i].pte = r->pte;
+			frames[i].rmap = r->next;
+			r->next = free_rmaps;
+			free_rmaps = r;
+		}
+		
+		return;
+	}
+	
+	/* Search extra entries. */
+	for (p = &frames[i].rmap; (r = *p) != NULL; p = &r->next)
+	{
+		if (r->pte == pg)
+		{
+			*p = r->next;
+			r->next = free_rmaps;
+			free_rmaps = r;
+			return;
+		}
+	}
+}
+
 /*============================================================================*
  *                             Swapping System                                *
  *============================================================================*/
 
 /**
  * @brief Swap space.
+ * 
+ * @details Block zero is never handed out, so that a non-present page table
+ *          entry with a null frame number never refers to the swap space.
  */
 PRIVATE struct
 {
 	unsigned count[SWP_SIZE/PAGE_SIZE];         /**< Reference count. */
 	uint32_t bitmap[(SWP_SIZE/PAGE_SIZE) >> 5]; /**< Bitmap.          */
-} swap = {{0, }, {0, } };
+	int busy;                                   /**< Swap I/O going?  */
+	struct process *chain;                      /**< Sleeping chain.  */
+	int cache[SWP_SIZE/PAGE_SIZE];              /**< Cached frame.    */
+	unsigned wblk;                              /**< Writing from.    */
+	unsigned wn;                                /**< Writing blocks.  */
+} swap = {{0, }, {1, }, 0, NULL, {0, }, 0, 0};
+
+/**
+ * @brief Asserts if a swap block is being written out.
+ * 
+ * @details While a swap block is being written out, swap.cache holds the
+ *          page frame that is being written, and the reverse map of that
+ *          page frame holds every page table entry that refers to the block.
+ * 
+ * @param blk Swap block.
+ */
+#define swap_writing(blk) \
+	(((blk) - swap.wblk) < swap.wn)
+
+/**
+ * @brief Swap buffer.
+ */
+PRIVATE char swap_buf[SWAP_CLUSTER*PAGE_SIZE]
+	__attribute__((aligned(PAGE_SIZE)));
+
+/**
+ * @brief Puts a page frame in the swap cache.
+ * 
+ * @param i   Index of the page frame.
+ * @param blk Swap block whose copy the page frame holds.
+ */
+PRIVATE void swap_cache(unsigned i, unsigned blk)
+{
+	frames[i].blk = blk;
+	swap.cache[blk] = i;
+	cache_link(i);
+}
+
+/**
+ * @brief Removes a page frame from the swap cache.
+ * 
+ * @param i Index of the page frame.
+ */
+PRIVATE void swap_uncache(unsigned i)
+{
+	cache_unlink(i);
+	swap.cache[frames[i].blk] = -1;
+}
+
+/**
+ * @brief Locks the swap space.
+ * 
+ * @details Swap I/O is serialized, so that a page is never swapped in before
+ *          it has been completely written to the swap space.
+ */
+PRIVATE void swap_lock(void)
+{
+	while (swap.busy)
+		sleep(&swap.chain, PRIO_REGION);
+	
+	swap.busy = 1;
+}
+
+/**
+ * @brief Unlocks the swap space.
+ */
+PRIVATE void swap_unlock(void)
+{
+	swap.busy = 0;
+	wakeup(&swap.chain);
+}
 
 /**
  * @brief Clears the swap space that is associated to a page.
@@ -79,125 +488,347 @@ PRIVATE struct
  */
 PRIVATE void swap_clear(struct pte *pg)
 {
+	int j;
 	unsigned i;
 	
 	i = pg->frame;
 	
+	/* Not in the swap space. */
+	if (i == 0)
+		return;
+	
+	/* Page is being written out. */
+	if (swap_writing(i))
+		rmap_remove(swap.cache[i], pg);
+	
 	/* Free swap space. */
 	if (swap.count[i] > 0)
 	{
-		bitmap_clear(swap.bitmap, i);
-		swap.count[i]--;
+		if (--swap.count[i] == 0)
+		{
+			bitmap_clear(swap.bitmap, i);
+			
+			/* Drop cached copy. */
+			if (!swap_writing(i) && ((j = swap.cache[i]) >= 0))
+			{
+				swap_uncache(j);
+				freef(j);
+			}
+		}
 	}
 }
 
 /**
- * @brief Swaps a page out to disk.
+ * @brief Allocates consecutive blocks in the swap space.
  * 
- * @param proc Process where the page is located.
- * @param addr Address of the page to be swapped out.
+ * @param n Number of blocks wanted. Upon return, it holds the number of
+ *          blocks actually found, which may be smaller.
  * 
- * @returns Zero upon success, and non-zero otherwise.
+ * @returns Upon success, the number of the first block is returned. Upon
+ *          failure, BITMAP_FULL is returned instead.
  */
-PRIVATE int swap_out(struct process *proc, addr_t addr)
+PRIVATE unsigned swap_alloc(unsigned *n)
 {
-	unsigned blk;   /* Block number in swap device.  */
-	struct pte *pg; /* Page table entry.             */
-	off_t off;      /* Offset in swap device.        */
-	ssize_t n;      /* # bytes written.              */
-	void *kpg;      /* Kernel page used for copying. */
+	unsigned blk; /* Working block.        */
+	unsigned run; /* Free blocks in a row. */
 	
-	addr &= PAGE_MASK;
-	pg = getpte(proc, addr);
+	for (/* noop */; *n > 0; *n /= 2)
+	{
+		run = 0;
+		
+		/* Block zero is reserved. */
+		for (blk = 1; blk < SWP_SIZE/PAGE_SIZE; blk++)
+		{
+			/* Used block. */
+			if (swap.bitmap[blk >> 5] & (1U << (blk & 31)))
+			{
+				run = 0;
+				continue;
+			}
+			
+			if (++run == *n)
+				return (blk - run + 1);
+		}
+	}
 	
-	/* Get kernel page. */
-	if ((kpg = getkpg(0)) == NULL)
-		goto error0;
+	return (BITMAP_FULL);
+}
+
+/**
+ * @brief Brings back a page frame whose swap out failed.
+ * 
+ * @details Every page table entry that still refers to the swap block maps
+ *          the page frame again. If several do, they share it copy on write.
+ * 
+ * @param i   Index of the page frame.
+ * @param blk Swap block.
+ * 
+ * @returns The number of page table entries that map the page frame.
+ */
+PRIVATE unsigned swap_rollback(unsigned i, unsigned blk)
+{
+	struct pte *pg;  /* Working page table entry. */
+	struct rmap *r;  /* Working reverse map.      */
+	unsigned count;  /* Page table entries.       */
 	
-	/* Get free block in swap device. */
-	blk = bitmap_first_free(swap.bitmap, (SWP_SIZE/PAGE_SIZE) >> 3);
-	if (blk == BITMAP_FULL)
-		goto error1;
+	count = 0;
+	for (pg = frames[i].pte, r = frames[i].rmap; pg != NULL; count++)
+	{
+		pg->present = 1;
+		pg->frame = FRAME_NUM(i);
+		swap.count[blk]--;
+		
+		pg = (r != NULL) ? r->pte : NULL;
+		r = (r != NULL) ? r->next : NULL;
+	}
+	
+	/* Shared page frame. */
+	if (count > 1)
+	{
+		for (pg = frames[i].pte, r = frames[i].rmap; pg != NULL; /* noop */)
+		{
+			if (pg->writable)
+			{
+				pg->writable = 0;
+				pg->cow = 1;
+			}
+			
+			pg = (r != NULL) ? r->pte : NULL;
+			r = (r != NULL) ? r->next : NULL;
+		}
+	}
+	
+	if (swap.count[blk] == 0)
+		bitmap_clear(swap.bitmap, blk);
+	
+	return (count);
+}
+
+/**
+ * @brief Swaps pages out to disk.
+ * 
+ * @details The pages are copied to the swap buffer and written to
+ *          consecutive blocks of the swap space in a single operation.
+ *          If there are not enough consecutive free blocks, only the first
+ *          pages are swapped out.
+ * 
+ *          The page frames stay locked and keep their reverse maps until the
+ *          write completes, so that page table entries which are linked or
+ *          freed meanwhile are accounted for, and so that the pages can be
+ *          brought back if the write fails.
+ * 
+ * @param victims Page frames to be swapped out.
+ * @param n       Number of page frames.
+ * 
+ * @returns Upon success, the number of pages that were swapped out is
+ *          returned. Upon failure, zero is returned instead.
+ * 
+ * @note The swap space must be locked.
+ * @note Every page table entry that maps a page frame is made to refer to
+ *       the same swap block, which holds one reference for each of them.
+ */
+PRIVATE unsigned swap_out(const int *victims, unsigned n)
+{
+	unsigned i;                    /* Page frame index.            */
+	unsigned k;                    /* Loop index.                  */
+	unsigned blk;                  /* Block number in swap device. */
+	off_t off;                     /* Offset in swap device.       */
+	ssize_t count;                 /* # bytes written.             */
+	struct pte *pg;                /* Working page table entry.    */
+	struct rmap *r;                /* Working reverse map.         */
+	
+	/* Get free blocks in swap device. */
+	if ((blk = swap_alloc(&n)) == BITMAP_FULL)
+		return (0);
 	
-	/*
-	 * Set block on swap device as used
-	 * in advance, because we may sleep below.
-	 */
 	off = HDD_SIZE + blk*PAGE_SIZE;
-	bitmap_set(swap.bitmap, blk);
-	
-	/* Write page to disk. */
-	kmemcpy(kpg, (void *)addr, PAGE_SIZE);
-	n = bdev_write(SWAP_DEV, (void *)addr, PAGE_SIZE, off);
-	if (n != PAGE_SIZE)
-		goto error2;
-	swap.count[blk]++;
-	
-	/* Set page as non-present. */
-	pg->present = 0;
-	pg->frame = blk;
+	
+	for (k = 0; k < n; k++)
+	{
+		i = victims[k];
+		
+		/*
+		 * Set block on swap device as used
+		 * in advance, because we may sleep below.
+		 */
+		bitmap_set(swap.bitmap, blk + k);
+		swap.cache[blk + k] = i;
+		frames[i].locked++;
+		
+		/*
+		 * The page may belong to any process, so copy
+		 * it through physical memory.
+		 */
+		physcpy(ADDR(&swap_buf[k*PAGE_SIZE]) - KBASE_VIRT,
+			FRAME_PHYS(i), PAGE_SIZE);
+		
+		/*
+		 * Set pages as non-present before writing them,
+		 * so that the page cannot change from now on.
+		 */
+		for (pg = frames[i].pte, r = frames[i].rmap; pg != NULL; /* noop */)
+		{
+			pg->present = 0;
+			pg->frame = blk + k;
+			swap.count[blk + k]++;
+			
+			pg = (r != NULL) ? r->pte : NULL;
+			r = (r != NULL) ? r->next : NULL;
+		}
+	}
 	tlb_flush();
 	
-	putkpg(kpg);
-	return (0);
-
-error2:
-	bitmap_clear(swap.bitmap, blk);
-error1:
-	putkpg(kpg);
-error0:
-	return (-1);
+	/* Write pages to disk. */
+	swap.wblk = blk;
+	swap.wn = n;
+	count = bdev_write(SWAP_DEV, swap_buf, n*PAGE_SIZE, off);
+	swap.wn = 0;
+	
+	/* Failed to write pages, so bring them back. */
+	if (count != (ssize_t)(n*PAGE_SIZE))
+	{
+		for (k = 0; k < n; k++)
+		{
+			i = victims[k];
+			
+			swap.cache[blk + k] = -1;
+			frames[i].locked--;
+			
+			/* Released meanwhile. */
+			if ((frames[i].count = swap_rollback(i, blk + k)) == 0)
+				freef(i);
+		}
+		tlb_flush();
+		
+		return (0);
+	}
+	
+	/* Page frames are no longer mapped. */
+	for (k = 0; k < n; k++)
+	{
+		i = victims[k];
+		
+		swap.cache[blk + k] = -1;
+		frames[i].locked--;
+		
+		while ((r = frames[i].rmap) != NULL)
+		{
+			frames[i].rmap = r->next;
+			r->next = free_rmaps;
+			free_rmaps = r;
+		}
+		frames[i].pte = NULL;
+	}
+	
+	return (n);
 }
 
 /**
- * @brief Swaps a page in to disk.
+ * @brief Swaps a page in from disk.
+ * 
+ * @details If the page is in the swap cache, it is mapped in without I/O.
+ *          Otherwise, the page is read along with the blocks in use that
+ *          follow it in the swap space, and these are kept in the swap cache
+ *          as long as the number of free page frames stays above
+ *          PAGES_FREE_LOW.
  * 
- * @param frame Frame number where the page should be placed.
- * @param addr  Address of the page to be swapped in.
+ * @param addr Address of the page to be swapped in.
  * 
  * @returns Zero upon success, and non-zero otherwise.
  */
-PRIVATE int swap_in(unsigned frame, addr_t addr)
+PRIVATE int swap_in(addr_t addr)
 {
+	int i, j;       /* Page frame indexes.           */
+	unsigned k;     /* Loop index.                   */
+	unsigned n;     /* Blocks to read.               */
 	unsigned blk;   /* Block number in swap device.  */
 	struct pte *pg; /* Page table entry.             */
 	off_t off;      /* Offset in swap device.        */
-	ssize_t n;      /* # bytes read.                 */
-	void *kpg;      /* Kernel page used for copying. */
+	ssize_t count;  /* # bytes read.                 */
 	
 	addr &= PAGE_MASK;
 	pg = getpte(curr_proc, addr);
+	blk = pg->frame;
 	
-	/* Get kernel page. */
-	if ((kpg = getkpg(0)) == NULL)
-		goto error0;
+	/* Page is being written out. */
+	if (swap_writing(blk))
+	{
+		swap_lock();
+		swap_unlock();
+		
+		/* Failed to write page, so it is back. */
+		if (pg->present)
+			return (0);
+	}
 	
-	/* Get block # in swap device. */
-	blk = pg->frame;
+	/* Swap cache hit. */
+	if ((i = swap.cache[blk]) >= 0)
+	{
+		swap_uncache(i);
+		takef(i);
+		curr_proc->minflt++;
+		goto found;
+	}
+	
+	if ((i = allocf()) < 0)
+		return (-1);
+	
+	swap_lock();
+	
+	/* Read around, but do not eat into the free page frame reserve. */
+	for (n = 1; n < SWAP_CLUSTER; n++)
+	{
+		if (nfree < PAGES_FREE_LOW + n)
+			break;
+		if (blk + n >= SWP_SIZE/PAGE_SIZE)
+			break;
+		if ((swap.count[blk + n] == 0) || (swap.cache[blk + n] >= 0))
+			break;
+	}
+	
+	/* Read pages from disk. */
 	off = HDD_SIZE + blk*PAGE_SIZE;
+	count = bdev_read(SWAP_DEV, swap_buf, n*PAGE_SIZE, off);
+	if (count != (ssize_t)(n*PAGE_SIZE))
+		goto error;
+	curr_proc->majflt++;
 	
-	/* Read page from disk. */
-	n = bdev_read(SWAP_DEV, kpg, PAGE_SIZE, off);
-	if (n != PAGE_SIZE)
-		goto error1;
+	physcpy(FRAME_PHYS(i), ADDR(swap_buf) - KBASE_VIRT, PAGE_SIZE);
+	
+	/* Cache the following pages. */
+	for (k = 1; (k < n) && (nfree > PAGES_FREE_LOW); k++)
+	{
+		/* Released or cached while we slept. */
+		if ((swap.count[blk + k] == 0) || (swap.cache[blk + k] >= 0))
+			continue;
+		
+		j = free_frames;
+		free_frames = frames[j].next;
+		nfree--;
+		
+		physcpy(FRAME_PHYS(j),
+			ADDR(&swap_buf[k*PAGE_SIZE]) - KBASE_VIRT, PAGE_SIZE);
+		swap_cache(j, blk + k);
+	}
+	
+	swap_unlock();
+
+found:
 	swap_clear(pg);
 	
 	/* Set page as present. */
 	pg->present = 1;
-	pg->frame = (UBASE_PHYS >> PAGE_SHIFT) + frame;
-	tlb_flush();
-	
-	/* Copy page. */
-	kmemcpy((void *)addr, kpg, PAGE_SIZE);
+	pg->frame = FRAME_NUM(i);
 	pg->accessed = 0;
 	pg->dirty = 0;
-		
-	putkpg(kpg);
+	tlb_flush_page(addr);
+	rmap_add(i, pg);
+	
 	return (0);
 
-error1:
-	putkpg(kpg);
-error0:
+error:
+	swap_unlock();
+	freef(i);
 	return (-1);
 }
 
@@ -205,13 +836,36 @@ error0:
  *                             Kernel Page Pool                               *
  *============================================================================*/
 
+/**
+ * @brief Gets the index of a kernel page.
+ * 
+ * @param p Kernel page.
+ */
+#define KPAGE(p) \
+	(((addr_t)(p) - KPOOL_VIRT) >> PAGE_SHIFT)
+
 /* Kernel pages. */
-#define NR_KPAGES (KPOOL_SIZE/PAGE_SIZE) /* Number of kernel pages.  */
 PRIVATE int kpages[NR_KPAGES] = { 0,  }; /* Reference count.         */
+PRIVATE void *free_kpages = NULL;        /* Free kernel pages.       */
+PRIVATE unsigned kpages_brk = 0;         /* Kernel pages never used. */
+
+/**
+ * @brief Kernel page pool statistics.
+ */
+PRIVATE struct
+{
+	unsigned used;  /**< Pages in use.        */
+	unsigned peak;  /**< Peak pages in use.   */
+	unsigned fails; /**< Failed allocations.  */
+} kpstat = { 0, 0, 0 };
 
 /**
  * @brief Allocates a kernel page.
  * 
+ * @details Released pages are kept in a free list that is linked through the
+ *          pages themselves. Pages that were never used are handed out in
+ *          order, once the free list is empty.
+ * 
  * @param clean Should the page be cleaned?
  * 
  * @returns Upon success, a pointer to a page is returned. Upon failure, a NULL
@@ -219,30 +873,33 @@ PRIVATE int kpages[NR_KPAGES] = { 0,  }; /* Reference count.         */
  */
 PUBLIC void *getkpg(int clean)
 {
-	unsigned i; /* Loop index.  */
+	unsigned i; /* Page index.  */
 	void *kpg;  /* Kernel page. */
 	
-	/* Search for a free kernel page. */
-	for (i = 0; i < NR_KPAGES; i++)
+	/* Released page. */
+	if ((kpg = free_kpages) != NULL)
+		free_kpages = *((void **)kpg);
+	
+	/* Never used page. */
+	else if (kpages_brk < NR_KPAGES)
+		kpg = (void *)(KPOOL_VIRT + (kpages_brk++ << PAGE_SHIFT));
+	
+	else
 	{
-		/* Found it. */
-		if (kpages[i] == 0)
-			goto found;
+		kprintf("mm: kernel page pool overflow");
+		kpstat.fails++;
+		return (NULL);
 	}
 
-	kprintf("mm: kernel page pool overflow");
-	
-	return (NULL);
-
-found:
-
 	/* Set page as used. */
-	kpg = (void *)(KPOOL_VIRT + (i << PAGE_SHIFT));
+	i = KPAGE(kpg);
 	kpages[i]++;
+	if (++kpstat.used > kpstat.peak)
+		kpstat.peak = kpstat.used;
 	
 	/* Clean page. */
 	if (clean)
-		kmemset(kpg, 0, PAGE_SIZE);
+		kpage_zero(kpg);
 	
 	return (kpg);
 }
@@ -256,7 +913,7 @@ PUBLIC void putkpg(void *kpg)
 {
 	unsigned i;
 	
-	i = ((addr_t)kpg - KPOOL_VIRT) >> PAGE_SHIFT;
+	i = KPAGE(kpg);
 	
 	/* Release page. */
 	kpages[i]--;
@@ -264,74 +921,459 @@ PUBLIC void putkpg(void *kpg)
 	/* Double free. */
 	if (kpages[i] < 0)
 		kpanic("mm: releasing kernel page twice");
+	
+	/* Still shared. */
+	if (kpages[i] > 0)
+		return;
+	
+	*((void **)kpg) = free_kpages;
+	free_kpages = kpg;
+	kpstat.used--;
+}
+
+/*============================================================================*
+ *                               Large Pages                                  *
+ *============================================================================*/
+
+/* Number of page frames in a large page. */
+#define LPAGE_FRAMES (PAGE_SIZE/PTE_SIZE)
+
+/* Number of large pages. */
+#define NR_LPAGES (NR_FRAMES/LPAGE_FRAMES)
+
+#if (UBASE_PHYS & (PGTAB_SIZE - 1))
+	#error "user memory not aligned on a large page"
+#endif
+
+/* Idle process page directory. */
+EXTERN struct pde idle_pgdir[];
+
+/**
+ * @brief Large pages.
+ * 
+ * @details A large page maps the 1024 page frames of a page table with a
+ *          single page directory entry. The page table is kept as a shadow of
+ *          the large page, so that it can be split back into small pages at
+ *          any time just by mapping the page table again. This happens on
+ *          fork(), when a page of it is freed, and before swapping out. The
+ *          page frames of a large page are locked meanwhile, so that they
+ *          are never swapped out.
+ */
+PRIVATE struct pde *lpages[NR_LPAGES] = { NULL, };
+
+/**
+ * @brief Are large pages supported?
+ */
+PRIVATE int lpages_ok = 0;
+
+/**
+ * @brief Maps a large page.
+ * 
+ * @details A large page is mapped only when the whole page table is still to
+ *          be demand zeroed, the page table is private and writable, and
+ *          1024 contiguous page frames are free.
+ * 
+ * @param reg  Memory region.
+ * @param t    Index of the page table in the memory region.
+ * @param addr Faulting address.
+ * 
+ * @returns Zero upon success, and non-zero otherwise.
+ */
+PRIVATE int alloclpg(struct region *reg, unsigned t, addr_t addr)
+{
+	int *p;                /* Working free list link.  */
+	int i;                 /* Page frame index.        */
+	unsigned j, k;         /* Loop indexes.            */
+	unsigned n[NR_LPAGES]; /* Free page frames.        */
+	struct pde *pde;       /* Page directory entry.    */
+	struct pte *pgtab;     /* Page table.              */
+	
+	pgtab = reg->pgtab[t];
+	
+	/* Not supported, or would start paging out. */
+	if ((!lpages_ok) || (nfree < LPAGE_FRAMES + PAGES_FREE_HIGH))
+		return (-1);
+	
+	/* Shared or read-only page table. */
+	if ((reg->flags & REGION_SHARED) || (!(reg->mode & MAY_WRITE)))
+		return (-1);
+	if (sharedpgtab(curr_proc, pgtab, addr))
+		return (-1);
+	
+	/* Page table in use. */
+	for (j = 0; j < LPAGE_FRAMES; j++)
+	{
+		if (!pgtab[j].zero)
+			return (-1);
+	}
+	
+	/* Search for a large page whose page frames are all free. */
+	kmemset(n, 0, sizeof(n));
+	for (i = free_frames; i >= 0; i = frames[i].next)
+		n[i/LPAGE_FRAMES]++;
+	for (k = 0; k < NR_LPAGES; k++)
+	{
+		if (n[k] == LPAGE_FRAMES)
+			break;
+	}
+	if (k == NR_LPAGES)
+		return (-1);
+	
+	/* Take page frames. */
+	for (p = &free_frames; *p >= 0; /* noop */)
+	{
+		if ((unsigned)*p/LPAGE_FRAMES == k)
+			*p = frames[*p].next;
+		else
+			p = &frames[*p].next;
+	}
+	nfree -= LPAGE_FRAMES;
+	
+	/* Build shadow page table. */
+	for (j = 0; j < LPAGE_FRAMES; j++)
+	{
+		i = k*LPAGE_FRAMES + j;
+		takef(i);
+		frames[i].locked++;
+		
+		kmemset(&pgtab[j], 0, sizeof(struct pte));
+		pgtab[j].present = 1;
+		pgtab[j].writable = 1;
+		pgtab[j].user = 1;
+		pgtab[j].frame = FRAME_NUM(i);
+		rmap_add(i, &pgtab[j]);
+	}
+	
+	/* Map large page. */
+	pde = getpde(curr_proc, addr);
+	pde->large = 1;
+	pde->frame = FRAME_NUM(k*LPAGE_FRAMES);
+	lpages[k] = pde;
+	tlb_flush();
+	
+	addr &= PGTAB_MASK;
+	for (j = 0; j < LPAGE_FRAMES; j++)
+		kpage_zero((void *)(addr + j*PAGE_SIZE));
+	
+	return (0);
+}
+
+/**
+ * @brief Splits a large page into small pages.
+ * 
+ * @param k Index of the large page.
+ * 
+ * @note The caller should flush the TLB.
+ */
+PRIVATE void splitlpg(unsigned k)
+{
+	unsigned i, j;     /* Loop indexes.         */
+	struct pde *pde;   /* Page directory entry. */
+	struct pte *pgtab; /* Shadow page table.    */
+	
+	pde = lpages[k];
+	pgtab = frames[k*LPAGE_FRAMES].pte;
+	
+	/* Hand page frames over to small pages. */
+	for (j = 0; j < LPAGE_FRAMES; j++)
+	{
+		i = k*LPAGE_FRAMES + j;
+		frames[i].locked--;
+		pgtab[j].accessed = pde->accessed;
+		pgtab[j].dirty = pde->dirty;
+	}
+	
+	/* Map shadow page table. */
+	pde->large = 0;
+	pde->dirty = 0;
+	pde->frame = (ADDR(pgtab) - KBASE_VIRT) >> PAGE_SHIFT;
+	lpages[k] = NULL;
 }
 
 /*============================================================================*
  *                              Paging System                                 *
  *============================================================================*/
 
-/* Number of page frames. */
-#define NR_FRAMES (UMEM_SIZE/PAGE_SIZE)
+/**
+ * @brief Chooses a page frame to be replaced.
+ * 
+ * @details Sweeps page frames with the clock algorithm: page frames that
+ *          were accessed through any of their pages since the last sweep
+ *          have the accessed bits cleared and get a second chance. Locked
+ *          and unmapped page frames are skipped.
+ * 
+ * @returns Upon success, the number of the frame is returned. Upon failure, a
+ *          negative number is returned instead.
+ */
+PRIVATE int pgvictim(void)
+{
+	int i;           /* Page frame index.         */
+	unsigned n;      /* Loop index.               */
+	int flush;       /* Flush the TLB?            */
+	int victim;      /* Chosen frame.             */
+	int accessed;    /* Page frame accessed?      */
+	struct pte *pg;  /* Working page table entry. */
+	struct rmap *r;  /* Working reverse map.      */
+	
+	flush = 0;
+	victim = -1;
+	
+	/* Two sweeps at most. */
+	for (n = 0; n < 2*NR_FRAMES; n++)
+	{
+		i = hand;
+		hand = (hand + 1)%NR_FRAMES;
+		
+		/* Skip page frame. */
+		if ((frames[i].locked) || (frames[i].pte == NULL))
+			continue;
+		
+		accessed = 0;
+		for (pg = frames[i].pte, r = frames[i].rmap; pg != NULL; /* noop */)
+		{
+			accessed |= pg->accessed;
+			pg->accessed = 0;
+			
+			pg = (r != NULL) ? r->pte : NULL;
+			r = (r != NULL) ? r->next : NULL;
+		}
+		
+		/* Second chance. */
+		if (accessed)
+		{
+			flush = 1;
+			continue;
+		}
+		
+		victim = i;
+		break;
+	}
+	
+	/* Accessed bits were cleared. */
+	if (flush)
+		tlb_flush();
+	
+	return (victim);
+}
 
 /**
- * @brief Page frames.
+ * @brief Asserts if a page frame is dirty.
+ * 
+ * @param i Index of the page frame.
+ * 
+ * @returns Non-zero if any page that maps the page frame is dirty, and zero
+ *          otherwise.
  */
-PRIVATE struct
+PRIVATE int pgdirty(unsigned i)
+{
+	struct pte *pg; /* Working page table entry. */
+	struct rmap *r; /* Working reverse map.      */
+	
+	for (pg = frames[i].pte, r = frames[i].rmap; pg != NULL; /* noop */)
+	{
+		if (pg->dirty)
+			return (1);
+		
+		pg = (r != NULL) ? r->pte : NULL;
+		r = (r != NULL) ? r->next : NULL;
+	}
+	
+	return (0);
+}
+
+/**
+ * @brief Drops a clean file page.
+ * 
+ * @details Every page that maps the page frame is set to be demand filled,
+ *          and the page frame is kept in the page cache, so that the next
+ *          access to any of these pages most likely maps it back without
+ *          I/O.
+ * 
+ * @param i Index of the page frame.
+ * 
+ * @note The caller should flush the TLB.
+ */
+PRIVATE void pgdrop(unsigned i)
+{
+	struct pte *pg; /* Page table entry. */
+	
+	while ((pg = frames[i].pte) != NULL)
+	{
+		rmap_remove(i, pg);
+		
+		kmemset(pg, 0, sizeof(struct pte));
+		markpg(pg, PAGE_FILL);
+	}
+	
+	cache_link(i);
+}
+
+/**
+ * @brief Swaps out a cluster of pages.
+ * 
+ * @details Clean pages of files are dropped rather than written to the swap
+ *          space, since they can be read back from the file.
+ * 
+ * @param n Number of pages wanted.
+ * 
+ * @returns The number of page frames that were released.
+ */
+PRIVATE unsigned pgout(unsigned n)
 {
-	unsigned count; /**< Reference count.     */
-	unsigned age;   /**< Age.                 */
-	pid_t owner;    /**< Page owner.          */
-	addr_t addr;    /**< Address of the page. */
-} frames[NR_FRAMES] = {{0, 0, 0, 0},  };
+	int i;                       /* Page frame index. */
+	unsigned k;                  /* Loop index.       */
+	unsigned nvictims;           /* Number of pages.  */
+	unsigned ndropped;           /* Dropped pages.    */
+	int victims[SWAP_CLUSTER];   /* Pages to evict.   */
+	
+	if (n > SWAP_CLUSTER)
+		n = SWAP_CLUSTER;
+	
+	swap_lock();
+	
+	/* Large pages cannot be swapped out, so split them. */
+	for (k = 0; k < NR_LPAGES; k++)
+	{
+		if (lpages[k] != NULL)
+		{
+			splitlpg(k);
+			tlb_flush();
+		}
+	}
+	
+	/* Choose pages. */
+	for (nvictims = 0, ndropped = 0; nvictims + ndropped < n; /* noop */)
+	{
+		if ((i = pgvictim()) < 0)
+			break;
+		
+		/* Clean file page. */
+		if ((frames[i].num != 0) && (!pgdirty(i)))
+		{
+			if (frames[i].count > 1)
+				nshared_out++;
+			pgdrop(i);
+			ndropped++;
+			continue;
+		}
+		
+		/* Do not choose it twice. */
+		frames[i].locked++;
+		victims[nvictims++] = i;
+	}
+	
+	for (k = 0; k < nvictims; k++)
+		frames[victims[k]].locked--;
+	
+	if (ndropped > 0)
+		tlb_flush();
+	
+	/* Swap pages out. */
+	if (nvictims > 0)
+	{
+		nvictims = swap_out(victims, nvictims);
+		for (k = 0; k < nvictims; k++)
+		{
+			if (frames[victims[k]].count > 1)
+				nshared_out++;
+			freef(victims[k]);
+		}
+	}
+	
+	swap_unlock();
+	
+	return (nvictims + ndropped);
+}
+
+/**
+ * @brief Allocates a page frame.
+ * 
+ * @details Page frames are usually taken from the free list, which the
+ *          page-out daemon keeps filled, and then from the cached page frames.
+ *          If both are empty, pages are swapped out right now.
+ * 
+ * @returns Upon success, the number of the frame is returned. Upon failure, a
+ *          negative number is returned instead.
+ */
+PRIVATE int allocf(void)
+{
+	int i; /* Page frame index. */
+	
+	/* Running out of page frames. */
+	if (nfree < PAGES_FREE_LOW)
+		wakeup(&kswapd_chain);
+	
+	/* Reclaim page frames. */
+	while ((free_frames < 0) && (cache_head < 0))
+	{
+		/* No frame left. */
+		if (pgout(SWAP_CLUSTER) == 0)
+			return (-1);
+	}
+	
+	/* Free page frame. */
+	if ((i = free_frames) >= 0)
+	{
+		free_frames = frames[i].next;
+		nfree--;
+	}
+	
+	/* Least recently cached page frame. */
+	else
+	{
+		i = cache_head;
+		if (frames[i].num != 0)
+		{
+			cache_unlink(i);
+			pcache_remove(i);
+		}
+		else
+			swap_uncache(i);
+	}
+	
+	takef(i);
+	
+	return (i);
+}
 
 /**
- * @brief Allocates a page frame.
+ * @brief Page-out daemon.
  * 
- * @returns Upon success, the number of the frame is returned. Upon failure, a
- *          negative number is returned instead.
+ * @details Swaps out clusters of pages whenever the number of free page
+ *          frames falls below PAGES_FREE_LOW, until it reaches
+ *          PAGES_FREE_HIGH, so that page faults seldom have to wait for a
+ *          page to be written to disk. The daemon is woken up by the page
+ *          frame allocator, checks the free list periodically, and
+ *          terminates when the system is shutting down.
+ * 
+ * @note This function never returns.
  */
-PRIVATE int allocf(void)
+PUBLIC void kswapd(void)
 {
-	int i;      /* Loop index.  */
-	int oldest; /* Oldest page. */
+	kstrncpy(curr_proc->name, "kswapd", NAME_MAX);
 	
-	#define OLDEST(x, y) (frames[x].age < frames[y].age)
-	
-	/* Search for a free frame. */
-	oldest = -1;
-	for (i = 0; i < NR_FRAMES; i++)
+	while (!shutting_down)
 	{
-		/* Found it. */
-		if (frames[i].count == 0)
-			goto found;
-		
-		/* Local page replacement policy. */
-		if (frames[i].owner == curr_proc->pid)
+		/* Refill free list. */
+		if (nfree < PAGES_FREE_LOW)
 		{
-			/* Skip shared pages. */
-			if (frames[i].count > 1)
-				continue;
-			
-			/* Oldest page found. */
-			if ((oldest < 0) || (OLDEST(i, oldest)))
-				oldest = i;
+			while (nfree < PAGES_FREE_HIGH)
+			{
+				if (pgout(SWAP_CLUSTER) == 0)
+					break;
+			}
 		}
+		
+		/* Wait for the next period. */
+		disable_interrupts();
+		curr_proc->alarm = ticks + KSWAPD_INTERVAL*CLOCK_FREQ;
+		sleep(&kswapd_chain, PRIO_SIG);
+		curr_proc->alarm = 0;
+		curr_proc->received = 0;
+		enable_interrupts();
 	}
 	
-	/* No frame left. */
-	if (oldest < 0)
-		return (-1);
-	
-	/* Swap page out. */
-	if (swap_out(curr_proc, frames[i = oldest].addr))
-		return (-1);
-	
-found:		
-
-	frames[i].age = ticks;
-	frames[i].count = 1;
-	
-	return (i);
+	die(0);
 }
 
 /**
@@ -357,7 +1399,7 @@ PRIVATE int cpypg(struct pte *pg1, struct pte *pg2)
 	pg1->writable = pg2->writable;
 	pg1->user = pg2->user;
 	pg1->cow = pg2->cow;
-	pg1->frame = (UBASE_PHYS >> PAGE_SHIFT) + i;
+	pg1->frame = FRAME_NUM(i);
 
 	physcpy(pg1->frame << PAGE_SHIFT, pg2->frame << PAGE_SHIFT, PAGE_SIZE);
 	
@@ -381,18 +1423,15 @@ PRIVATE int allocupg(addr_t addr, int writable)
 	if ((i = allocf()) < 0)
 		return (-1);
 	
-	/* Initialize page frame. */
-	frames[i].owner = curr_proc->pid;
-	frames[i].addr = addr & PAGE_MASK;
-	
 	/* Allocate page. */
 	pg = getpte(curr_proc, addr);
 	kmemset(pg, 0, sizeof(struct pte));
 	pg->present = 1;
 	pg->writable = (writable) ? 1 : 0;
 	pg->user = 1;
-	pg->frame = (UBASE_PHYS >> PAGE_SHIFT) + i;
-	tlb_flush();
+	pg->frame = FRAME_NUM(i);
+	rmap_add(i, pg);
+	tlb_flush_page(addr);
 	
 	return (0);
 }
@@ -407,6 +1446,8 @@ PRIVATE int allocupg(addr_t addr, int writable)
  */
 PRIVATE int readpg(struct region *reg, addr_t addr)
 {
+	int i;               /* Page frame index.         */
+	int shared;          /* Shared page?              */
 	char *p;             /* Read pointer.             */
 	off_t off;           /* Block offset.             */
 	ssize_t count;       /* Bytes read.               */
@@ -414,6 +1455,38 @@ PRIVATE int readpg(struct region *reg, addr_t addr)
 	struct pte *pg;      /* Working page table entry. */
 	
 	addr &= PAGE_MASK;
+	off = reg->file.off + (PG(addr) << PAGE_SHIFT);
+	inode = reg->file.inode;
+	
+	/* Read-only pages are shared. */
+	shared = !(reg->mode & MAY_WRITE);
+	if ((shared) && ((i = pcache_lookup(inode, off)) >= 0))
+	{
+		pg = getpte(curr_proc, addr);
+		
+		/* Reverse map overflow. */
+		if (rmap_add(i, pg))
+			return (-1);
+		
+		/* Cached page frame. */
+		if (frames[i].count == 0)
+		{
+			cache_unlink(i);
+			frames[i].count = 1;
+			frames[i].locked = 0;
+		}
+		else
+			frames[i].count++;
+		
+		kmemset(pg, 0, sizeof(struct pte));
+		pg->present = 1;
+		pg->user = 1;
+		pg->frame = FRAME_NUM(i);
+		tlb_flush_page(addr);
+		curr_proc->minflt++;
+		
+		return (0);
+	}
 	
 	/* Assign a user page. */
 	if (allocupg(addr, reg->mode & MAY_WRITE))
@@ -421,23 +1494,33 @@ PRIVATE int readpg(struct region *reg, addr_t addr)
 	
 	/* Find page table entry. */
 	pg = getpte(curr_proc, addr);
+	i = pg->frame - FRAME_NUM(0);
 	
-	/* Read page. */
-	off = reg->file.off + (PG(addr) << PAGE_SHIFT);
-	inode = reg->file.inode;
+	/*
+	 * Read page. The page frame cannot be
+	 * replaced while we sleep, waiting for I/O.
+	 */
 	p = (char *)(addr & PAGE_MASK);
-	count = file_read(inode, p, PAGE_SIZE, off);
+	frames[i].locked++;
+	count = file_read(inode, p, PAGE_SIZE, off, NULL);
+	frames[i].locked--;
 	
 	/* Failed to read page. */
 	if (count < 0)
 	{
 		freeupg(pg);
+		tlb_flush_page(addr);
 		return (-1);
 	}
 	
 	/* Fill remainder bytes with zero. */
 	else if (count < PAGE_SIZE)
 		kmemset(p + count, 0, PAGE_SIZE - count);
+	curr_proc->majflt++;
+	
+	/* Share page, unless someone else was faster. */
+	if ((shared) && (pcache_lookup(inode, off) < 0))
+		pcache_insert(i, inode, off);
 	
 	return (0);
 }
@@ -459,15 +1542,15 @@ PUBLIC void mappgtab(struct process *proc, addr_t addr, void *pgtab)
 	if (pde->present)
 		kpanic("busy page table entry");
 	
-	/* Map kernel page. */
+	/* Map kernel page. Shared page tables are write protected. */
 	pde->present = 1;
-	pde->writable = 1;
+	pde->writable = (kpages[KPAGE(pgtab)] == 1) ? 1 : 0;
 	pde->user = 1;
 	pde->frame = (ADDR(pgtab) - KBASE_VIRT) >> PAGE_SHIFT;
 	
 	/* Flush changes. */
 	if (proc == curr_proc)
-		tlb_flush();
+		tlb_flush_page(addr);
 }
 
 /**
@@ -477,6 +1560,8 @@ PUBLIC void mappgtab(struct process *proc, addr_t addr, void *pgtab)
  * @param addr Address where the page should be unmapped.
  * 
  * @returns Zero upon success, and non zero otherwise.
+ * 
+ * @note The caller should flush the TLB.
  */
 PUBLIC void umappgtab(struct process *proc, addr_t addr)
 {
@@ -487,19 +1572,21 @@ PUBLIC void umappgtab(struct process *proc, addr_t addr)
 	/* Bad page table. */
 	if (!(pde->present))
 		kpanic("unmap non-present page table");
+	
+	/* Large page. */
+	if (pde->large)
+		splitlpg((pde->frame - FRAME_NUM(0))/LPAGE_FRAMES);
 
 	/* Unmap kernel page. */
 	kmemset(pde, 0, sizeof(struct pde));
-	
-	/* Flush changes. */
-	if (proc == curr_proc)
-		tlb_flush();
 }
 
 /**
  * @brief Frees a user page.
  * 
  * @param pg Page to be freed.
+ * 
+ * @note The caller should flush the TLB.
  */
 PUBLIC void freeupg(struct pte *pg)
 {
@@ -513,17 +1600,104 @@ PUBLIC void freeupg(struct pte *pg)
 		return;
 	}
 		
-	i = pg->frame - (UBASE_PHYS >> PAGE_SHIFT);
+	i = pg->frame - FRAME_NUM(0);
+	
+	/* Large page. */
+	if (lpages[i/LPAGE_FRAMES] != NULL)
+		splitlpg(i/LPAGE_FRAMES);
 		
 	/* Double free. */
 	if (frames[i].count == 0)
 		kpanic("freeing user page twice");
 	
 	/* Free user page. */
-	if (--frames[i].count)
-		frames[i].owner = 0;
+	rmap_remove(i, pg);
+	if (--frames[i].count == 0)
+	{
+		/* Keep file page. */
+		if (frames[i].num != 0)
+			cache_link(i);
+		else
+			freef(i);
+	}
 	kmemset(pg, 0, sizeof(struct pte));
-	tlb_flush();
+}
+
+/**
+ * @brief Purges cached pages of a file.
+ * 
+ * @details Page frames that are still mapped keep their contents but are no
+ *          longer shared with new mappings. Unused page frames are released.
+ * 
+ * @param ip File inode.
+ */
+PUBLIC void purgepg(struct inode *ip)
+{
+	int i, next;
+	
+	i = pcache[PCACHE_HASH(ip->dev, ip->num)];
+	for (/* noop */; i >= 0; i = next)
+	{
+		next = frames[i].hnext;
+		
+		/* Some other file. */
+		if ((frames[i].dev != ip->dev) || (frames[i].num != ip->num))
+			continue;
+		
+		pcache_remove(i);
+		
+		/* Unused page frame. */
+		if (frames[i].count == 0)
+		{
+			cache_unlink(i);
+			freef(i);
+		}
+	}
+}
+
+/**
+ * @brief Gets page statistics.
+ * 
+ * @param buf Location where statistics shall be stored.
+ */
+PUBLIC void pgstat(struct mstat *buf)
+{
+	buf->ms_kpages = NR_KPAGES;
+	buf->ms_kpages_used = kpstat.used;
+	buf->ms_kpages_peak = kpstat.peak;
+	buf->ms_kpages_fail = kpstat.fails;
+	buf->ms_frames = NR_FRAMES;
+	buf->ms_frames_free = nfree;
+	buf->ms_shared_out = nshared_out;
+}
+
+/**
+ * @brief Initializes the paging system.
+ * 
+ * @details Puts all page frames and extra reverse mapping entries in their
+ *          free lists, and empties the swap and page caches.
+ */
+PUBLIC void initpg(void)
+{
+	int i;
+	
+	for (i = NR_FRAMES - 1; i >= 0; i--)
+		freef(i);
+	
+	for (i = 0; i < SWP_SIZE/PAGE_SIZE; i++)
+		swap.cache[i] = -1;
+	
+	for (i = 0; i < PCACHE_HASHTAB_SIZE; i++)
+		pcache[i] = -1;
+	
+	for (i = NR_RMAPS - 1; i >= 0; i--)
+	{
+		rmaps[i].next = free_rmaps;
+		free_rmaps = &rmaps[i];
+	}
+	
+	/* Boot code maps the kernel with a large page, if supported. */
+	lpages_ok = idle_pgdir[PGTAB(KBASE_VIRT)].large;
 }
 
 /**
@@ -560,14 +1734,22 @@ PUBLIC void markpg(struct pte *pg, int mark)
  * 
  * @param upg1 Source page.
  * @param upg2 Target page.
+ * 
+ * @returns Zero upon success, and non-zero otherwise.
  */
-PUBLIC void linkupg(struct pte *upg1, struct pte *upg2)
+PUBLIC int linkupg(struct pte *upg1, struct pte *upg2)
 {	
 	unsigned i;
 
 	/* In-core page. */
 	if (upg1->present)
 	{
+		i = upg1->frame - FRAME_NUM(0);
+		
+		/* Reverse map overflow. */
+		if (rmap_add(i, upg2))
+			return (-1);
+		
 		/* Set copy on write. */
 		if (upg1->writable)
 		{
@@ -575,18 +1757,205 @@ PUBLIC void linkupg(struct pte *upg1, struct pte *upg2)
 			upg1->cow = 1;
 		}
 	
-		i = upg1->frame - (UBASE_PHYS >> PAGE_SHIFT);
 		frames[i].count++;
 	}
 	
 	/* In-disk page. */
-	else
+	else if (upg1->frame != 0)
 	{
-		 i = upg1->frame;
-		 swap.count[i]++;
+		i = upg1->frame;
+		
+		/* Reverse map overflow. */
+		if (swap_writing(i) && rmap_add(swap.cache[i], upg2))
+			return (-1);
+		
+		swap.count[i]++;
 	}
 	
 	kmemcpy(upg2, upg1, sizeof(struct pte));
+	
+	return (0);
+}
+
+/**
+ * @brief Shares a page table.
+ * 
+ * @param pgtab Page table to be shared.
+ * 
+ * @returns The shared page table.
+ * 
+ * @note Page tables that are shared get write protected when mapped.
+ */
+PUBLIC struct pte *linkpgtab(struct pte *pgtab)
+{
+	kpages[KPAGE(pgtab)]++;
+	
+	return (pgtab);
+}
+
+/**
+ * @brief Frees a page table.
+ * 
+ * @details Pages are released along with the last reference to the page
+ *          table.
+ * 
+ * @param pgtab Page table to be freed.
+ */
+PUBLIC void freepgtab(struct pte *pgtab)
+{
+	unsigned i;
+	
+	/* Last reference. */
+	if (kpages[KPAGE(pgtab)] == 1)
+	{
+		for (i = 0; i < PAGE_SIZE/PTE_SIZE; i++)
+			freeupg(&pgtab[i]);
+	}
+	
+	putkpg(pgtab);
+}
+
+/**
+ * @brief Makes a page table of a memory region private.
+ * 
+ * @details If the page table is shared, its pages are linked into a new page
+ *          table, and the region switches to it. In any case, the page table
+ *          is mapped back with write access.
+ * 
+ * @param proc Process where the memory region is attached (may be NULL).
+ * @param reg  Memory region.
+ * @param i    Index of the page table in the memory region.
+ * @param addr Address where the page table is mapped.
+ * 
+ * @returns Zero upon success, and non-zero otherwise.
+ * 
+ * @note The caller should flush the TLB.
+ */
+PUBLIC int unsharepgtab
+(struct process *proc, struct region *reg, unsigned i, addr_t addr)
+{
+	unsigned j, k;      /* Loop indexes.    */
+	struct pte *pgtab;  /* New page table. */
+	
+	/* Shared page table. */
+	if (kpages[KPAGE(reg->pgtab[i])] > 1)
+	{
+		if ((pgtab = getkpg(1)) == NULL)
+			return (-1);
+		
+		/* Link underlying pages. */
+		for (j = 0; j < PAGE_SIZE/PTE_SIZE; j++)
+		{
+			/* Failed to link page. */
+			if (linkupg(&reg->pgtab[i][j], &pgtab[j]))
+			{
+				for (k = 0; k < j; k++)
+					freeupg(&pgtab[k]);
+				putkpg(pgtab);
+				return (-1);
+			}
+		}
+		
+		putkpg(reg->pgtab[i]);
+		reg->pgtab[i] = pgtab;
+	}
+	
+	/* Remap page table. */
+	if (proc != NULL)
+	{
+		umappgtab(proc, addr);
+		mappgtab(proc, addr, reg->pgtab[i]);
+	}
+	
+	return (0);
+}
+
+/**
+ * @brief Asserts if a page table must be made private before changing it.
+ * 
+ * @param proc  Process where the page table is mapped.
+ * @param pgtab Page table.
+ * @param addr  Address where the page table is mapped.
+ * 
+ * @returns Non-zero if the page table is shared or is mapped write
+ *          protected, and zero otherwise.
+ */
+PUBLIC int sharedpgtab(struct process *proc, struct pte *pgtab, addr_t addr)
+{
+	return ((kpages[KPAGE(pgtab)] > 1) || (!getpde(proc, addr)->writable));
+}
+
+/**
+ * @brief Counts the pages of a process.
+ * 
+ * @details Pages in shared regions and page tables are accounted to
+ *          every process that maps them.
+ * 
+ * @param proc     Target process.
+ * @param resident Store location for the number of resident pages.
+ * @param swapped  Store location for the number of swapped out pages.
+ */
+PUBLIC void pgusage(struct process *proc, unsigned *resident, unsigned *swapped)
+{
+	unsigned i, j, k;   /* Loop indexes.             */
+	struct pte *pg;     /* Working page table entry. */
+	struct region *reg; /* Working memory region.    */
+	
+	*resident = 0;
+	*swapped = 0;
+	
+	for (i = 0; i < NR_PREGIONS; i++)
+	{
+		/* Region not attached. */
+		if ((reg = proc->pregs[i].reg) == NULL)
+			continue;
+		
+		for (j = 0; j < REGION_PGTABS; j++)
+		{
+			/* Skip invalid page tables. */
+			if (reg->pgtab[j] == NULL)
+				continue;
+			
+			for (k = 0; k < PAGE_SIZE/PTE_SIZE; k++)
+			{
+				pg = &reg->pgtab[j][k];
+				
+				if (pg->present)
+					(*resident)++;
+				
+				/* Block zero is never used, so it means no page. */
+				else if (!pg->zero && !pg->fill && (pg->frame != 0))
+					(*swapped)++;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Clones the kernel stack of the current running process.
+ * 
+ * @param proc   Target process.
+ * @param kstack Kernel stack of the target process.
+ */
+PRIVATE void clonekstack(struct process *proc, void *kstack)
+{
+	dword_t off;              /* Stack offset.     */
+	struct intstack *s1, *s2; /* Interrupt stacks. */
+	
+	/* Clone live part of kernel stack. */
+	off = curr_proc->kesp - (dword_t)curr_proc->kstack;
+	kmemcpy((char *)kstack + off, (char *)curr_proc->kstack + off,
+		KSTACK_SIZE - off);
+	
+	/* Adjust stack pointers. */
+	proc->kesp = (curr_proc->kesp -(dword_t)curr_proc->kstack)+(dword_t)kstack;
+	if (KERNEL_RUNNING(curr_proc))
+	{
+		s1 = (struct intstack *) curr_proc->kesp;
+		s2 = (struct intstack *) proc->kesp;	
+		s2->ebp = (s1->ebp - (dword_t)curr_proc->kstack) + (dword_t)kstack;
+	}
+	proc->kstack = kstack;
 }
 
 /**
@@ -599,9 +1968,8 @@ PUBLIC void linkupg(struct pte *upg1, struct pte *upg2)
  */
 PUBLIC int crtpgdir(struct process *proc)
 {
-	void *kstack;             /* Kernel stack.     */
-	struct pde *pgdir;        /* Page directory.   */
-	struct intstack *s1, *s2; /* Interrupt stacks. */
+	void *kstack;      /* Kernel stack.   */
+	struct pde *pgdir; /* Page directory. */
 	
 	/* Get kernel page for page directory. */
 	pgdir = getkpg(1);
@@ -619,21 +1987,11 @@ PUBLIC int crtpgdir(struct process *proc)
 	pgdir[PGTAB(KPOOL_VIRT)] = curr_proc->pgdir[PGTAB(KPOOL_VIRT)];
 	pgdir[PGTAB(INITRD_VIRT)] = curr_proc->pgdir[PGTAB(INITRD_VIRT)];
 	
-	/* Clone kernel stack. */
-	kmemcpy(kstack, curr_proc->kstack, KSTACK_SIZE);
+	clonekstack(proc, kstack);
 	
-	/* Adjust stack pointers. */
-	proc->kesp = (curr_proc->kesp -(dword_t)curr_proc->kstack)+(dword_t)kstack;
-	if (KERNEL_RUNNING(curr_proc))
-	{
-		s1 = (struct intstack *) curr_proc->kesp;
-		s2 = (struct intstack *) proc->kesp;	
-		s2->ebp = (s1->ebp - (dword_t)curr_proc->kstack) + (dword_t)kstack;
-	}
 	/* Assign page directory. */
 	proc->cr3 = ADDR(pgdir) - KBASE_VIRT;
 	proc->pgdir = pgdir;
-	proc->kstack = kstack;
 	
 	return (0);
 
@@ -643,6 +2001,71 @@ err0:
 	return (-1);
 }
 
+/**
+ * @brief Shares the page directory of the current running process.
+ * 
+ * @details The target process runs on the address space of the current
+ *          running process until it calls unshrpgdir().
+ * 
+ * @param proc Target process.
+ * 
+ * @returns Upon successful completion, zero is returned. Upon failure, non-zero
+ *          is returned instead.
+ */
+PUBLIC int shrpgdir(struct process *proc)
+{
+	void *kstack; /* Kernel stack. */
+	
+	/* Get kernel page for kernel stack. */
+	kstack = getkpg(0);
+	if (kstack == NULL)
+		return (-1);
+	
+	clonekstack(proc, kstack);
+	
+	/* Share page directory. */
+	kpages[KPAGE(curr_proc->pgdir)]++;
+	proc->cr3 = curr_proc->cr3;
+	proc->pgdir = curr_proc->pgdir;
+	
+	return (0);
+}
+
+/**
+ * @brief Gives a process a page directory of its own.
+ * 
+ * @details The new page directory maps the kernel only.
+ * 
+ * @param proc Target process.
+ * 
+ * @returns Upon successful completion, zero is returned. Upon failure, non-zero
+ *          is returned instead.
+ */
+PUBLIC int unshrpgdir(struct process *proc)
+{
+	struct pde *pgdir; /* Page directory. */
+	
+	/* Get kernel page for page directory. */
+	pgdir = getkpg(1);
+	if (pgdir == NULL)
+		return (-1);
+	
+	/* Build page directory. */
+	pgdir[0] = proc->pgdir[0];
+	pgdir[PGTAB(KBASE_VIRT)] = proc->pgdir[PGTAB(KBASE_VIRT)];
+	pgdir[PGTAB(KPOOL_VIRT)] = proc->pgdir[PGTAB(KPOOL_VIRT)];
+	pgdir[PGTAB(INITRD_VIRT)] = proc->pgdir[PGTAB(INITRD_VIRT)];
+	
+	/* Drop shared page directory. */
+	putkpg(proc->pgdir);
+	proc->cr3 = ADDR(pgdir) - KBASE_VIRT;
+	proc->pgdir = pgdir;
+	if (proc == curr_proc)
+		tlb_load(proc->cr3);
+	
+	return (0);
+}
+
 /**
  * @brief Destroys the page directory of a process.
  * 
@@ -666,7 +2089,7 @@ PUBLIC void dstrypgdir(struct process *proc)
  */
 PUBLIC int vfault(addr_t addr)
 {
-	int frame;            /* Frame index of page to be swapped in. */
+	unsigned t;           /* Page table index.                     */
 	struct pte *pg;       /* Working page.                         */
 	struct region *reg;   /* Working region.                       */
 	struct pregion *preg; /* Working process region.               */
@@ -692,16 +2115,30 @@ PUBLIC int vfault(addr_t addr)
 			goto error1;
 	}
 
-	pg = (reg->flags & REGION_DOWNWARDS) ?
-		&reg->pgtab[REGION_PGTABS-(PGTAB(preg->start)-PGTAB(addr))-1][PG(addr)]: 
-		&reg->pgtab[PGTAB(addr) - PGTAB(preg->start)][PG(addr)];
+	t = (reg->flags & REGION_DOWNWARDS) ?
+		REGION_PGTABS - (PGTAB(preg->start) - PGTAB(addr)) - 1 :
+		PGTAB(addr) - PGTAB(preg->start);
+	
+	/* Page table was shared by fork(). */
+	if ((reg->mode & MAY_WRITE) && (!getpde(curr_proc, addr)->writable))
+	{
+		if (unsharepgtab(curr_proc, reg, t, addr & PGTAB_MASK))
+			goto error1;
+		tlb_flush();
+	}
+	
+	pg = &reg->pgtab[t][PG(addr)];
 		
-	/* Clear page. */
+	/* Clear page, or the whole page table at once. */
 	if (pg->zero)
 	{
-		if (allocupg(addr, reg->mode & MAY_WRITE))
-			goto error1;
-		kmemset((void *)(addr & PAGE_MASK), 0, PAGE_SIZE);
+		if (alloclpg(reg, t, addr))
+		{
+			if (allocupg(addr, reg->mode & MAY_WRITE))
+				goto error1;
+			kpage_zero((void *)(addr & PAGE_MASK));
+		}
+		curr_proc->minflt++;
 	}
 		
 	/* Load page from executable file. */
@@ -713,20 +2150,15 @@ PUBLIC int vfault(addr_t addr)
 	}
 		
 	/* Swap page in. */
-	else
+	else if (!pg->present)
 	{
-		if ((frame = allocf()) < 0)
+		if (swap_in(addr))
 			goto error1;
-		if (swap_in(frame, addr))
-			goto error2;
-		frames[frame].addr = addr & PAGE_MASK;
 	}
 	
 	unlockreg(reg);
 	return (0);
 
-error2:
-	frames[frame].count = 0;
 error1:
 	unlockreg(reg);
 error0:
@@ -742,7 +2174,9 @@ error0:
  */
 PUBLIC int pfault(addr_t addr)
 {
+	int err;              /* Error?                  */
 	unsigned i;           /* Frame index.            */
+	unsigned t;           /* Page table index.       */
 	struct pte *pg;       /* Faulting page.          */
 	struct pte new_pg;    /* New page.               */
 	struct region *reg;   /* Working memory region.  */
@@ -756,28 +2190,53 @@ PUBLIC int pfault(addr_t addr)
 	
 	lockreg(reg = preg->reg);
 
-	pg = (reg->flags & REGION_DOWNWARDS) ?
-		&reg->pgtab[REGION_PGTABS-(PGTAB(preg->start)-PGTAB(addr))-1][PG(addr)]: 
-		&reg->pgtab[PGTAB(addr) - PGTAB(preg->start)][PG(addr)];
+	t = (reg->flags & REGION_DOWNWARDS) ?
+		REGION_PGTABS - (PGTAB(preg->start) - PGTAB(addr)) - 1 :
+		PGTAB(addr) - PGTAB(preg->start);
+	
+	/* Page table was shared by fork(). */
+	if ((reg->mode & MAY_WRITE) && (!getpde(curr_proc, addr)->writable))
+	{
+		if (unsharepgtab(curr_proc, reg, t, addr & PGTAB_MASK))
+			goto error1;
+		tlb_flush();
+	}
+	
+	pg = &reg->pgtab[t][PG(addr)];
 
+	/* Page was swapped out meanwhile, so fault again. */
+	if (!pg->present)
+		goto out;
+	
+	/* Page table was write protected. */
+	if (pg->writable)
+		goto out;
+	
 	/* Copy on write not enabled. */
 	if (!pg->cow)
 		goto error1;
 		
-	i = pg->frame - (UBASE_PHYS >> PAGE_SHIFT);
+	i = pg->frame - FRAME_NUM(0);
 
 	/* Duplicate page. */
 	if (frames[i].count > 1)
 	{
-		if (cpypg(&new_pg, pg))
+		/* Page frame cannot be replaced while we copy it. */
+		frames[i].locked++;
+		err = cpypg(&new_pg, pg);
+		frames[i].locked--;
+		if (err)
 			goto error1;
 		
 		new_pg.cow = 0;
 		new_pg.writable = 1;
 		
 		/* Unlik page. */
-		frames[i].count--;
+		rmap_remove(i, pg);
+		if (--frames[i].count == 0)
+			freef(i);
 		kmemcpy(pg, &new_pg, sizeof(struct pte));
+		rmap_add(pg->frame - FRAME_NUM(0), pg);
 	}
 		
 	/* Steal page. */
@@ -786,7 +2245,10 @@ PUBLIC int pfault(addr_t addr)
 		pg->cow = 0;
 		pg->writable = 1;
 	}
+	tlb_flush_page(addr);
+	curr_proc->cowflt++;
 	
+out:
 	unlockreg(reg);
 	return(0);
 
@@ -35,6 +35,17 @@
  */
 PRIVATE struct region regtab[NR_REGIONS];
 
+/**
+ * @brief Gets the address where a page table of a memory region is mapped.
+ * 
+ * @param preg Process region where the memory region is attached.
+ * @param i    Index of the page table.
+ */
+#define pgtabaddr(preg, i)                                            \
+	(((preg)->reg->flags & REGION_DOWNWARDS) ?                        \
+		(preg)->start - (REGION_PGTABS - 1 - (i))*PGTAB_SIZE :        \
+		(preg)->start + (i)*PGTAB_SIZE)
+
 /**
  * @brief Expands a memory region.
  * 
@@ -180,6 +191,7 @@ PRIVATE int contract(struct process *proc, struct region *reg, size_t size)
 {
 	unsigned i, j;        /* Loop indexes.                  */
 	unsigned npages;      /* Number of pages in the region. */
+	size_t oldsize;       /* Old region size.               */
 	struct pregion *preg; /* Working process region.        */
 	
 	size = ALIGN(size, PAGE_SIZE);
@@ -190,6 +202,7 @@ PRIVATE int contract(struct process *proc, struct region *reg, size_t size)
 
 	preg = reg->preg;
 	npages = reg->size >> PAGE_SHIFT;
+	oldsize = reg->size;
 	
 	/* Contract downwards. */
 	if (reg->flags & REGION_DOWNWARDS)
@@ -257,6 +270,15 @@ PRIVATE int contract(struct process *proc, struct region *reg, size_t size)
 		}
 	}
 	
+	/* Flush removed pages. */
+	if (proc == curr_proc)
+	{
+		if (reg->flags & REGION_DOWNWARDS)
+			tlb_flush_range(preg->start - oldsize, preg->start - reg->size);
+		else
+			tlb_flush_range(preg->start + reg->size, preg->start + oldsize);
+	}
+	
 	return (0);
 }
 
@@ -349,7 +371,7 @@ found:
  */
 PUBLIC void freereg(struct region *reg)
 {
-	unsigned i, j;
+	unsigned i;
 	
 	/* Sticky region. */
 	if (reg->flags & REGION_STICKY)
@@ -363,13 +385,8 @@ PUBLIC void freereg(struct region *reg)
 	for (i = 0; i < REGION_PGTABS; i++)
 	{
 		/* Skip invalid page tables. */
-		if (reg->pgtab[i] == NULL)
-			continue;
-		
-		/* Free underlying pages. */
-		for (j = 0; j < PAGE_SIZE/PTE_SIZE; j++)	
-			freeupg(&reg->pgtab[i][j]);
-		putkpg(reg->pgtab[i]);
+		if (reg->pgtab[i] != NULL)
+			freepgtab(reg->pgtab[i]);
 	}
 	
 	reg->flags = REGION_FREE;
@@ -530,6 +547,16 @@ PUBLIC void detachreg(struct process *proc, struct pregion *preg)
 			addr += PGTAB_SIZE;
 		}
 	}
+	
+	/* Flush region pages. */
+	if (proc == curr_proc)
+	{
+		if (reg->flags & REGION_DOWNWARDS)
+			tlb_flush_range(preg->start - reg->size, preg->start + PAGE_SIZE);
+		else
+			tlb_flush_range(preg->start, preg->start + reg->size);
+	}
+	
 	preg->reg = NULL;
 	proc->size -= reg->size;
 	if (--reg->count < 0)
@@ -552,7 +579,8 @@ PUBLIC void detachreg(struct process *proc, struct pregion *preg)
  */
 PUBLIC struct region *dupreg(struct region *reg)
 {
-	unsigned i, j;          /* Loop index.        */
+	unsigned i;             /* Loop index.        */
+	addr_t addr;            /* Page table address. */
 	struct region *new_reg; /* New memory region. */
 		
 	/* Shared region. */
@@ -560,20 +588,31 @@ PUBLIC struct region *dupreg(struct region *reg)
 		return (reg);
 	
 	/* Failed to allocate new region. */
-	if ((new_reg = allocreg(reg->mode, reg->size, reg->flags)) == NULL)
+	if ((new_reg = allocreg(reg->mode, 0, reg->flags)) == NULL)
 		return (NULL);
 	
-	/* Link underlying page tables. */
+	/*
+	 * Share underlying page tables. Pages get
+	 * linked only when a page table is written.
+	 */
 	for (i = 0; i < REGION_PGTABS; i++)
 	{
+		if (new_reg->pgtab[i] != NULL)
+			putkpg(new_reg->pgtab[i]);
+		new_reg->pgtab[i] = NULL;
+		
 		/* Skip invalid page tables. */
 		if (reg->pgtab[i] == NULL)
 			continue;
-			
-		/* Link underlying pages. */
-		for (j = 0; j < PAGE_SIZE/PTE_SIZE; j++)
-			linkupg(&reg->pgtab[i][j], &new_reg->pgtab[i][j]);
+		
+		new_reg->pgtab[i] = linkpgtab(reg->pgtab[i]);
+		
+		/* Write protect our page table. */
+		addr = pgtabaddr(reg->preg, i);
+		umappgtab(curr_proc, addr);
+		mappgtab(curr_proc, addr, reg->pgtab[i]);
 	}
+	new_reg->size = reg->size;
 	
 	/* Copy region fields. */
 	if (reg->file.inode != NULL)
@@ -598,6 +637,8 @@ PUBLIC struct region *dupreg(struct region *reg)
  */
 PUBLIC int growreg(struct process *proc, struct pregion *preg, ssize_t size)
 {
+	unsigned i;
+	int flush;
 	struct region *reg;
 	
 	/* Attached shared regions may not grow. */
@@ -608,6 +649,29 @@ PUBLIC int growreg(struct process *proc, struct pregion *preg, ssize_t size)
 	if (!(reg->flags & (REGION_DOWNWARDS | REGION_UPWARDS)))
 		return (-EINVAL);
 	
+	/* Page tables shared by fork() are about to change. */
+	flush = 0;
+	for (i = 0; i < REGION_PGTABS; i++)
+	{
+		if (reg->pgtab[i] == NULL)
+			continue;
+		
+		if (!sharedpgtab(proc, reg->pgtab[i], pgtabaddr(preg, i)))
+			continue;
+		
+		if (unsharepgtab(proc, reg, i, pgtabaddr(preg, i)))
+		{
+			if ((flush) && (proc == curr_proc))
+				tlb_flush();
+			return (-ENOMEM);
+		}
+		
+		flush = 1;
+	}
+	
+	if ((flush) && (proc == curr_proc))
+		tlb_flush();
+	
 	/* Contract region */
 	if (size < 0)
 		contract(proc, reg, -size);
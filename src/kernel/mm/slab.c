@@ -0,0 +1,250 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <nanvix/const.h>
+#include <nanvix/klib.h>
+#include <nanvix/mm.h>
+#include <sys/mstat.h>
+#include "mm.h"
+
+/* Smallest object size (as a shift). */
+#define KMALLOC_MIN_SHIFT 4
+
+/* Number of object caches. */
+#define NR_KCACHES (PAGE_SHIFT - KMALLOC_MIN_SHIFT + 1)
+
+/**
+ * @brief Object cache.
+ * 
+ * @details Objects of a cache are carved out of kernel pages (slabs). Slabs
+ *          that have free objects are kept in a list, so that both allocating
+ *          and releasing an object take constant time.
+ */
+PRIVATE struct
+{
+	size_t size;    /**< Object size.               */
+	int partial;    /**< Slabs with free objects.   */
+	unsigned nobjs; /**< Objects in use.            */
+} kcaches[NR_KCACHES];
+
+/**
+ * @brief Slab descriptors.
+ * 
+ * @details Descriptors are kept apart from slabs, indexed by kernel page, so
+ *          that objects fill whole pages and are found by their address.
+ */
+PRIVATE struct
+{
+	int cache;      /**< Owner cache (negative if none). */
+	int prev;       /**< Previous slab in the list.      */
+	int next;       /**< Next slab in the list.          */
+	void *free;     /**< Free objects.                   */
+	unsigned inuse; /**< Objects in use.                 */
+} slabs[NR_KPAGES];
+
+/**
+ * @brief Number of kernel pages used by slabs.
+ */
+PRIVATE unsigned nslabs = 0;
+
+/**
+ * @brief Gets the index of the kernel page where an object lives.
+ * 
+ * @param p Object.
+ */
+#define SLAB(p) \
+	((unsigned)(((addr_t)(p) - KPOOL_VIRT) >> PAGE_SHIFT))
+
+/**
+ * @brief Removes a slab from the list of its cache.
+ * 
+ * @param i Slab index.
+ */
+PRIVATE void slab_unlink(int i)
+{
+	if (slabs[i].prev >= 0)
+		slabs[slabs[i].prev].next = slabs[i].next;
+	else
+		kcaches[slabs[i].cache].partial = slabs[i].next;
+	
+	if (slabs[i].next >= 0)
+		slabs[slabs[i].next].prev = slabs[i].prev;
+}
+
+/**
+ * @brief Inserts a slab in the list of its cache.
+ * 
+ * @param i Slab index.
+ */
+PRIVATE void slab_link(int i)
+{
+	int c;
+	
+	c = slabs[i].cache;
+	
+	slabs[i].prev = -1;
+	slabs[i].next = kcaches[c].partial;
+	if (kcaches[c].partial >= 0)
+		slabs[kcaches[c].partial].prev = i;
+	kcaches[c].partial = i;
+}
+
+/**
+ * @brief Creates a slab.
+ * 
+ * @param c Cache index.
+ * 
+ * @returns Upon success, the index of the new slab is returned. Upon failure,
+ *          a negative number is returned instead.
+ */
+PRIVATE int slab_create(int c)
+{
+	int i;       /* Slab index.     */
+	char *p;     /* Working object. */
+	char *kpg;   /* Slab page.      */
+	size_t size; /* Object size.    */
+	
+	if ((kpg = getkpg(0)) == NULL)
+		return (-1);
+	
+	i = SLAB(kpg);
+	size = kcaches[c].size;
+	
+	/* Chain objects. */
+	for (p = kpg; p + size < kpg + PAGE_SIZE; p += size)
+		*((void **)p) = p + size;
+	*((void **)p) = NULL;
+	
+	slabs[i].cache = c;
+	slabs[i].free = kpg;
+	slabs[i].inuse = 0;
+	slab_link(i);
+	nslabs++;
+	
+	return (i);
+}
+
+/**
+ * @brief Allocates a small kernel object.
+ * 
+ * @param size Object size.
+ * 
+ * @returns Upon success, a pointer to the object is returned. Upon failure, a
+ *          NULL pointer is returned instead.
+ */
+PUBLIC void *kmalloc(size_t size)
+{
+	int c;   /* Cache index. */
+	int i;   /* Slab index.  */
+	void *p; /* Object.      */
+	
+	/* Too large. */
+	if (size > PAGE_SIZE)
+		return (NULL);
+	
+	/* Find cache. */
+	for (c = 0; kcaches[c].size < size; c++)
+		noop();
+	
+	/* Grab a slab. */
+	if ((i = kcaches[c].partial) < 0)
+	{
+		if ((i = slab_create(c)) < 0)
+			return (NULL);
+	}
+	
+	p = slabs[i].free;
+	slabs[i].free = *((void **)p);
+	slabs[i].inuse++;
+	kcaches[c].nobjs++;
+	
+	/* Slab is full. */
+	if (slabs[i].free == NULL)
+		slab_unlink(i);
+	
+	return (p);
+}
+
+/**
+ * @brief Releases a small kernel object.
+ * 
+ * @param p Object to be released.
+ */
+PUBLIC void kfree(void *p)
+{
+	int c; /* Cache index. */
+	int i; /* Slab index.  */
+	
+	i = SLAB(p);
+	
+	/* Bad object. */
+	if ((c = slabs[i].cache) < 0)
+		kpanic("mm: releasing bad kernel object");
+	
+	/* Slab was full. */
+	if (slabs[i].free == NULL)
+		slab_link(i);
+	
+	*((void **)p) = slabs[i].free;
+	slabs[i].free = p;
+	slabs[i].inuse--;
+	kcaches[c].nobjs--;
+	
+	/* Release empty slab. */
+	if (slabs[i].inuse == 0)
+	{
+		slab_unlink(i);
+		slabs[i].cache = -1;
+		putkpg((void *)(KPOOL_VIRT + (i << PAGE_SHIFT)));
+		nslabs--;
+	}
+}
+
+/**
+ * @brief Gets object cache statistics.
+ * 
+ * @param buf Location where statistics shall be stored.
+ */
+PUBLIC void slabstat(struct mstat *buf)
+{
+	int c;
+	
+	buf->ms_slabs = nslabs;
+	buf->ms_objects = 0;
+	for (c = 0; c < NR_KCACHES; c++)
+		buf->ms_objects += kcaches[c].nobjs;
+}
+
+/**
+ * @brief Initializes the object caches.
+ */
+PUBLIC void initslab(void)
+{
+	int i;
+	
+	for (i = 0; i < NR_KCACHES; i++)
+	{
+		kcaches[i].size = 1 << (KMALLOC_MIN_SHIFT + i);
+		kcaches[i].partial = -1;
+		kcaches[i].nobjs = 0;
+	}
+	
+	for (i = 0; i < NR_KPAGES; i++)
+		slabs[i].cache = -1;
+}
@@ -96,6 +96,10 @@ PUBLIC void die(int status)
 		}
 	}
 	
+	/* Give borrowed memory regions back. */
+	if (curr_proc->flags & (1 << PROC_VFORK))
+		vfrelease();
+	
 	/* Detach process memory regions. */
 	for (unsigned i = 0; i < NR_PREGIONS; i++)
 		detachreg(curr_proc, &curr_proc->pregs[i]);
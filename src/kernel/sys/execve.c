@@ -153,21 +153,21 @@ PRIVATE addr_t load_elf32(struct inode *inode)
  */
 PRIVATE int count(const char **str)
 {
-	int s;          /* Working string. */
-	const char **r; /* Read pointer.   */
-	int c;          /* String couynt.  */
+	int c;         /* String count.   */
+	const char *s; /* Working string. */
 	
 	/* Count the number of strings. */
-	for (c = 0, r = str; (s = fudword(r)) != 0; r++)
-	{				
+	for (c = 0; /* noop. */; c++)
+	{
 		/* Bad string vector. */
-		if (s == -1)
+		if (copy_from_user(&s, &str[c], sizeof(const char *)))
 		{
 			curr_proc->errno = -EFAULT;
 			return (-1);
 		}
-			
-		c++;
+		
+		if (s == NULL)
+			break;
 	}
 	
 	return (c);
@@ -176,48 +176,39 @@ PRIVATE int count(const char **str)
 /*
  * Copy strings of a vector of strings to somewhere.
  */
-PRIVATE int copy_strings(int count, const char **strings, char *where, int p, const int bypass)
+PRIVATE int copy_strings
+(int count, const char **strings, char *where, int p, int size)
 {
-	int ch;          /* Working character.     */
+	ssize_t len;     /* Working string length. */
 	const char *str; /* Working string.        */
-	int length;      /* Working string length. */
 	
 	/* Copy strings. */
-	while (count-- > 0)
+	for (int i = 0; i < count; i++)
 	{
-		str = (bypass) ? *strings : (const char *)fudword(strings + count);
-		length = 1;
-		
-		/* Get working string length. */
-		while ((ch = ((bypass) ? *str : fubyte(str))) != '\0')
-		{			
-			/* Bad string. */
-			if (ch < 0)
-			{
-				curr_proc->errno = -EFAULT;
-				return (-1);
-			}
-			
-			length++;
-			str++;
+		/* Bad string vector. */
+		if (copy_from_user(&str, &strings[i], sizeof(const char *)))
+		{
+			curr_proc->errno = -EFAULT;
+			return (-1);
 		}
 		
+		len = strncpy_from_user(&where[p], str, size - p);
 		
-		/* Copy working string. */
-		while (length-- > 0)
+		/* Bad string. */
+		if (len < 0)
 		{
-			where[p] = (char) fubyte(str);
+			curr_proc->errno = len;
+			return (-1);
+		}
 		
-			p--;
-			str--;
-			
-			/* Strings too long. */
-			if (p < 0)
-			{
-				curr_proc->errno = -E2BIG;
-				return (-1);
-			}
+		/* Strings too long. */
+		if (len == size - p)
+		{
+			curr_proc->errno = -E2BIG;
+			return (-1);
 		}
+		
+		p += len + 1;
 	}
 	
 	return (p);
@@ -296,11 +287,17 @@ PRIVATE addr_t buildargs
 		return (0);
 		
 	/* Copy argv and envp to stack. */
-	if ((p = copy_strings(envc, envp, stack, size - 1, 0)) < 0)
+	if ((p = copy_strings(argc, argv, stack, 0, size)) < 0)
 		return (0);
-	if ((p = copy_strings(argc, argv, stack, p, 0)) < 0)
+	if ((p = copy_strings(envc, envp, stack, p, size)) < 0)
 		return (0);
-	if ((p = create_tables(stack, size, p, argc, envc)) == 0)
+	
+	/* Move strings to the top of the stack. */
+	for (int i = p - 1; i >= 0; i--)
+		((char *)stack)[size - p + i] = ((char *)stack)[i];
+	kmemset(stack, 0, size - p);
+	
+	if ((p = create_tables(stack, size, size - p - 1, argc, envc)) == 0)
 		return (0);
 		
 	return (p);
@@ -376,6 +373,18 @@ PUBLIC int sys_execve(const char *filename, const char **argv, const char **envp
 		return (-EACCES);
 	}
 
+	/* Give borrowed address space back. */
+	if (curr_proc->flags & (1 << PROC_VFORK))
+	{
+		if (unshrpgdir(curr_proc))
+		{
+			putname(pathname);
+			inode_put(inode);
+			return (-ENOMEM);
+		}
+		vfrelease();
+	}
+
 	/* Close file descriptors. */
 	for (i = 0; i < OPEN_MAX; i++)
 	{
@@ -26,16 +26,20 @@
 #include <sys/types.h>
 #include <errno.h>
 
-/*
- * Creates a new process.
+/**
+ * @brief Processes waiting for vfork() children.
  */
-PUBLIC pid_t sys_fork(void)
+PRIVATE struct process *chain = NULL;
+
+/**
+ * @brief Gets a free process slot.
+ * 
+ * @returns A free process slot. If the process table is full, NULL is
+ *          returned instead.
+ */
+PRIVATE struct process *getproc(void)
 {
-	int i;                /* Loop index.     */
-	int err;              /* Error?          */
-	struct process *proc; /* Process.        */
-	struct region *reg;   /* Memory region.  */
-	struct pregion *preg; /* Process region. */
+	struct process *proc;
 
 #if (EDUCATIONAL_KERNEL == 0)
 
@@ -45,7 +49,7 @@ PUBLIC pid_t sys_fork(void)
 	 * user can invoke kill() if something goes wrong.
 	 */
 	if ((nprocs + 1 >= PROC_MAX) && (!IS_SUPERUSER(curr_proc)))
-		return (-EAGAIN);
+		return (NULL);
 
 #endif
 
@@ -54,62 +58,23 @@ PUBLIC pid_t sys_fork(void)
 	{
 		/* Found. */
 		if (!IS_VALID(proc))
-			goto found;
+			return (proc);
 	}
 
 	kprintf("process table overflow");
 	
-	return (-EAGAIN);
-
-found:
-	
-	/* Mark process as beeing created. */
-	proc->flags = 1 << PROC_NEW;
+	return (NULL);
+}
 
-	err = crtpgdir(proc);
-	
-	/* Failed to create process page directory. */
-	if (err)
-		goto error0;
-	
-	/*
-	 * Duplicate attached regions.
-	 * Notice that regions will be attached in the child process
-	 * on the same indexes as in the father process.
-	 */
-	for (i = 0; i < NR_PREGIONS; i++)
-	{	
-		preg = &curr_proc->pregs[i];
-		
-		/* Process region not in use. */
-		if (preg->reg == NULL)
-			continue;	
-			
-		lockreg(preg->reg);
-		reg = dupreg(preg->reg);
-		unlockreg(preg->reg);
-		
-		/* Failed to duplicate region. */
-		if (reg == NULL)
-			goto error1;
-		
-		err = attachreg(proc, &proc->pregs[i], preg->start, reg);
-		
-		/* Failed to attach region. */
-		if (err)
-		{
-			/*
-			 * FIXME: region count.
-			 */
-			kpanic("failed to attach region");
-			freereg(reg);
-			goto error1;
-		}
-			
-		unlockreg(reg);
-	}
+/**
+ * @brief Initializes a child of the current running process.
+ * 
+ * @param proc Child process.
+ */
+PRIVATE void initproc(struct process *proc)
+{
+	int i;
 	
-	/* Initialize process. */
 	proc->intlvl = INT_LVL_5;
 	proc->received = 0;
 	proc->restorer = curr_proc->restorer;
@@ -118,6 +83,9 @@ found:
 		proc->handlers[i] = curr_proc->handlers[i];
 	proc->irqlvl = curr_proc->irqlvl;
 	proc->size = curr_proc->size;
+	proc->minflt = 0;
+	proc->majflt = 0;
+	proc->cowflt = 0;
 	proc->pwd = curr_proc->pwd;
 	proc->pwd->count++;
 	proc->root = curr_proc->root;
@@ -159,6 +127,73 @@ found:
 	curr_proc->nchildren++;
 	
 	nprocs++;
+}
+
+/*
+ * Creates a new process.
+ */
+PUBLIC pid_t sys_fork(void)
+{
+	int i;                /* Loop index.     */
+	int err;              /* Error?          */
+	struct process *proc; /* Process.        */
+	struct region *reg;   /* Memory region.  */
+	struct pregion *preg; /* Process region. */
+
+	/* Get a free process slot. */
+	if ((proc = getproc()) == NULL)
+		return (-EAGAIN);
+	
+	/* Mark process as beeing created. */
+	proc->flags = 1 << PROC_NEW;
+
+	err = crtpgdir(proc);
+	
+	/* Failed to create process page directory. */
+	if (err)
+		goto error0;
+	
+	/*
+	 * Duplicate attached regions.
+	 * Notice that regions will be attached in the child process
+	 * on the same indexes as in the father process.
+	 */
+	for (i = 0; i < NR_PREGIONS; i++)
+	{	
+		preg = &curr_proc->pregs[i];
+		
+		/* Process region not in use. */
+		if (preg->reg == NULL)
+			continue;	
+			
+		lockreg(preg->reg);
+		reg = dupreg(preg->reg);
+		unlockreg(preg->reg);
+		
+		/* Failed to duplicate region. */
+		if (reg == NULL)
+			goto error1;
+		
+		err = attachreg(proc, &proc->pregs[i], preg->start, reg);
+		
+		/* Failed to attach region. */
+		if (err)
+		{
+			/*
+			 * FIXME: region count.
+			 */
+			kpanic("failed to attach region");
+			freereg(reg);
+			goto error1;
+		}
+			
+		unlockreg(reg);
+	}
+	
+	/* Our writable pages are now copy on write. */
+	tlb_flush();
+	
+	initproc(proc);
 	
 	return (proc->pid);
 
@@ -180,3 +215,62 @@ error0:
 	proc->flags = 0;
 	return (-ENOMEM);
 }
+
+/*
+ * Creates a new process that borrows our address space.
+ */
+PUBLIC pid_t sys_vfork(void)
+{
+	int i;                /* Loop index.        */
+	pid_t pid;            /* Child process ID.  */
+	struct process *proc; /* Process.           */
+
+	/* Get a free process slot. */
+	if ((proc = getproc()) == NULL)
+		return (-EAGAIN);
+	
+	/* Mark process as beeing created. */
+	proc->flags = (1 << PROC_NEW) | (1 << PROC_VFORK);
+	
+	/* Failed to create kernel stack. */
+	if (shrpgdir(proc))
+	{
+		proc->flags = 0;
+		return (-ENOMEM);
+	}
+	
+	/* Lend attached regions. */
+	for (i = 0; i < NR_PREGIONS; i++)
+		proc->pregs[i] = curr_proc->pregs[i];
+	
+	initproc(proc);
+	
+	/*
+	 * Wait until the child calls execve() or _exit(),
+	 * since it is running on our stack. This sleep is
+	 * not interruptible, otherwise we could die while
+	 * our address space is still in use.
+	 */
+	pid = proc->pid;
+	while (proc->flags & (1 << PROC_VFORK))
+		sleep(&chain, PRIO_REGION);
+	
+	return (pid);
+}
+
+/**
+ * @brief Gives a borrowed address space back to the father process.
+ * 
+ * @details The current running process shall have been created by vfork().
+ */
+PUBLIC void vfrelease(void)
+{
+	int i;
+	
+	for (i = 0; i < NR_PREGIONS; i++)
+		curr_proc->pregs[i].reg = NULL;
+	curr_proc->size = 0;
+	
+	curr_proc->flags &= ~(1 << PROC_VFORK);
+	wakeup(&chain);
+}
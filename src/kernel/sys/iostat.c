@@ -0,0 +1,53 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <nanvix/const.h>
+#include <nanvix/dev.h>
+#include <nanvix/fs.h>
+#include <nanvix/mm.h>
+#include <sys/iostat.h>
+#include <errno.h>
+
+/**
+ * @brief Gets block device I/O statistics.
+ * 
+ * @details Gets I/O statistics of the block device dev, and stores them in the
+ *          buffer pointed to by buf.
+ * 
+ * @param dev Number of the block device to be queried.
+ * @param buf Location where I/O statistics shall be dumped.
+ * 
+ * @returns Upon successful completion, zero is returned. Upon failure, a 
+ *          negative error number is returned instead.
+ */
+PUBLIC int sys_iostat(dev_t dev, struct iostat *buf)
+{
+	int ret; /* Return value. */
+	
+	/* Invalid buffer. */
+	if (!chkmem(buf, sizeof(struct iostat), MAY_WRITE))
+		return (-EINVAL);
+	
+	if ((ret = bdev_stat(dev, buf)) < 0)
+		return (ret);
+	
+	bstat(dev, buf);
+	
+	return (0);
+}
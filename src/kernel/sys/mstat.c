@@ -0,0 +1,47 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <nanvix/const.h>
+#include <nanvix/mm.h>
+#include <sys/mstat.h>
+#include <errno.h>
+
+/**
+ * @brief Gets memory statistics.
+ * 
+ * @details Gets statistics of the kernel page pool, of the kernel object
+ *          caches and of user page frames, and stores them in the buffer
+ *          pointed to by buf.
+ * 
+ * @param buf Location where memory statistics shall be dumped.
+ * 
+ * @returns Upon successful completion, zero is returned. Upon failure, a 
+ *          negative error number is returned instead.
+ */
+PUBLIC int sys_mstat(struct mstat *buf)
+{
+	/* Invalid buffer. */
+	if (!chkmem(buf, sizeof(struct mstat), MAY_WRITE))
+		return (-EINVAL);
+	
+	pgstat(buf);
+	slabstat(buf);
+	
+	return (0);
+}
@@ -237,6 +237,9 @@ PUBLIC int sys_open(const char *path, int oflag, mode_t mode)
 	f->oflag = oflag;
 	f->pos = 0;
 	f->inode = i;
+	f->ra.next = 0;
+	f->ra.ahead = 0;
+	f->ra.window = 0;
 	
 	curr_proc->ofiles[fd] = f;
 	curr_proc->close &= ~(1 << fd);
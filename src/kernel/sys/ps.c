@@ -18,6 +18,7 @@
  */
 
 #include <nanvix/klib.h>
+#include <nanvix/mm.h>
 #include <nanvix/pm.h>
 
 void reverse(char* s)
@@ -140,6 +141,51 @@ PUBLIC int sys_ps()
 			uid, priority, nice, utime, ktime, states[(int)p->state] );
 	}
 
+	kprintf("-------------------------------- Memory Status"
+			" -------------------------------\n"
+		    "NAME               PID   RESIDENT  SWAPPED   MINFLT    MAJFLT"
+		    "    COW");
+
+	char resident[26];
+	char swapped [26];
+	char minflt  [26];
+	char majflt  [26];
+	char cowflt  [26];
+	unsigned nresident, nswapped;
+
+	for (p = IDLE; p <= LAST_PROC; p++)
+	{
+		/* Skip invalid processes. */
+		if (!IS_VALID(p))
+			continue;
+
+		/* Name */
+		size = kstrlen(p->name);
+		kstrcpy(name, p->name);
+		len = 20 - size;
+
+		for(i=size; i<len+size-1; i++)
+			*(name+i) = ' ';
+
+		*(name+i) = '\0';
+
+		/* Pid */
+		prepareValue(p->pid, pid, 6);
+
+		/* Resident and swapped out pages */
+		pgusage(p, &nresident, &nswapped);
+		prepareValue(nresident, resident, 10);
+		prepareValue(nswapped, swapped, 10);
+
+		/* Page faults */
+		prepareValue(p->minflt, minflt, 10);
+		prepareValue(p->majflt, majflt, 10);
+		prepareValue(p->cowflt, cowflt, 10);
+
+		kprintf("%s%s%s%s%s%s%s",name, pid,
+			resident, swapped, minflt, majflt, cowflt);
+	}
+
 	kprintf("\nLast process: %s, pid: %d\n",last_proc->name, last_proc->pid);
 	return 0;
 }
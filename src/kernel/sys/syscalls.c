@@ -20,6 +20,15 @@
 
 #include <nanvix/const.h>
 #include <nanvix/syscall.h>
+#include <errno.h>
+
+/*
+ * Unimplemented system call.
+ */
+PRIVATE int sys_nosys(void)
+{
+	return (-ENOSYS);
+}
 
 /*
  * System calls table.
@@ -72,5 +81,12 @@ PUBLIC void (*syscalls_table[NR_SYSCALLS])(void)  = {
 	(void (*)(void))&sys_times,
 	(void (*)(void))&sys_shutdown,
 	(void (*)(void))&sys_ps,
-	(void (*)(void))&sys_gticks
+	(void (*)(void))&sys_gticks,
+	(void (*)(void))&sys_nosys,
+	(void (*)(void))&sys_nosys,
+	(void (*)(void))&sys_nosys,
+	(void (*)(void))&sys_iostat,
+	(void (*)(void))&sys_mstat,
+	(void (*)(void))&sys_vfork,
+	(void (*)(void))&sys_waitpid
 };
@@ -35,14 +35,16 @@
  */
 PUBLIC clock_t sys_times(struct tms *buffer)
 {
+	struct tms t; /* Timing information. */
+	
+	t.tms_utime = curr_proc->utime*CLOCK_FREQ;
+	t.tms_stime = curr_proc->ktime*CLOCK_FREQ;
+	t.tms_cutime = curr_proc->cutime*CLOCK_FREQ;
+	t.tms_cstime = curr_proc->cktime*CLOCK_FREQ;
+	
 	/* Not a valid buffer. */
-	if (!chkmem(buffer, sizeof(struct tms), MAY_WRITE))
+	if (copy_to_user(buffer, &t, sizeof(struct tms)))
 		return (-EINVAL);
 	
-	buffer->tms_utime = curr_proc->utime*CLOCK_FREQ;
-	buffer->tms_stime = curr_proc->ktime*CLOCK_FREQ;
-	buffer->tms_cutime = curr_proc->cutime*CLOCK_FREQ;
-	buffer->tms_cstime = curr_proc->cktime*CLOCK_FREQ;
-	
 	return (CURRENT_TIME*CLOCK_FREQ);
 }
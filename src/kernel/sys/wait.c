@@ -21,6 +21,7 @@
 #include <nanvix/mm.h>
 #include <nanvix/pm.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <errno.h>
 
 /* Sleeping chain. */
@@ -29,15 +30,20 @@ PRIVATE struct process *chain = NULL;
 /*
  * Waits for a child process to terminate.
  */
-PUBLIC pid_t sys_wait(int *stat_loc)
+PUBLIC pid_t sys_waitpid(pid_t pid, int *stat_loc, int options)
 {
 	int sig;
-	pid_t pid;
+	int found;
+	pid_t ret;
 	struct process *p;
 
 	/* Has no permissions to write at stat_loc. */
 	if ((stat_loc != NULL) && (!chkmem(stat_loc, sizeof(int), MAY_WRITE)))
 		return (-EINVAL);
+	
+	/* Invalid options. */
+	if (options & ~WNOHANG)
+		return (-EINVAL);
 
 repeat:
 
@@ -46,53 +52,72 @@ repeat:
 		return (-ECHILD);
 
 	/* Look for child processes. */
+	found = 0;
 	for (p = FIRST_PROC; p <= LAST_PROC; p++)
 	{
 		/* Skip invalid processes. */
 		if (!IS_VALID(p))
 			continue;
+		
+		/* Not a child process. */
+		if (p->father != curr_proc)
+			continue;
+		
+		/* Not waited for. */
+		if ((pid > 0) && (p->pid != pid))
+			continue;
+		if ((pid == 0) && (p->pgrp != curr_proc->pgrp))
+			continue;
+		if ((pid < -1) && (p->pgrp->pid != -pid))
+			continue;
+		
+		found = 1;
+		
+		/* Stopped. */
+		if (p->state == PROC_STOPPED)
+		{
+			/* Already reported. */
+			if (p->status)
+				continue;
+			
+			p->status = 1 << 10;
 			
-		 /* Found. */
-		if (p->father == curr_proc)
+			/* Get exit code. */
+			if (stat_loc != NULL)
+				*stat_loc = p->status;
+			
+			return (p->pid);
+		}
+		
+		/* Terminated. */
+		else if (p->state == PROC_ZOMBIE)
 		{
-			/* Stopped. */
-			if (p->state == PROC_STOPPED)
-			{
-				/* Already reported. */
-				if (p->status)
-					continue;
-				
-				p->status = 1 << 10;
-				
-				/* Get exit code. */
-				if (stat_loc != NULL)
-					*stat_loc = p->status;
-				
-				return (p->pid);
-			}
+			/* Get exit code. */
+			if (stat_loc != NULL)
+				*stat_loc = p->status;
 			
-			/* Terminated. */
-			else if (p->state == PROC_ZOMBIE)
-			{
-				/* Get exit code. */
-				if (stat_loc != NULL)
-					*stat_loc = p->status;
-				
-				/* 
-				 * Get information from child
-				 * process before burying it.
-				 */
-				pid = p->pid;
-				curr_proc->cutime += p->utime;
-				curr_proc->cktime += p->ktime;
+			/* 
+			 * Get information from child
+			 * process before burying it.
+			 */
+			ret = p->pid;
+			curr_proc->cutime += p->utime;
+			curr_proc->cktime += p->ktime;
 
-				/* Bury child process. */
-				bury(p);
-				
-				return (pid);
-			}
+			/* Bury child process. */
+			bury(p);
+			
+			return (ret);
 		}
 	}
+	
+	/* No such child process. */
+	if (!found)
+		return (-ECHILD);
+	
+	/* Do not wait. */
+	if (options & WNOHANG)
+		return (0);
 
 	sleep(&chain, PRIO_USER);
 	sig = issig();
@@ -103,3 +128,11 @@ repeat:
 		
 	return (-EINTR);
 }
+
+/*
+ * Waits for any child process to terminate.
+ */
+PUBLIC pid_t sys_wait(int *stat_loc)
+{
+	return (sys_waitpid(-1, stat_loc, 0));
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <signal.h>
+
+/*
+ * Is sig a valid signal?
+ */
+#define VALID(sig) \
+	(((sig) > 0) && ((sig) < NR_SIGNALS))
+
+/*
+ * Empties a signal set.
+ */
+int sigemptyset(sigset_t *set)
+{
+	*set = 0;
+	
+	return (0);
+}
+
+/*
+ * Fills a signal set.
+ */
+int sigfillset(sigset_t *set)
+{
+	*set = (1 << NR_SIGNALS) - 2;
+	
+	return (0);
+}
+
+/*
+ * Adds a signal to a signal set.
+ */
+int sigaddset(sigset_t *set, int sig)
+{
+	/* Invalid signal. */
+	if (!VALID(sig))
+	{
+		errno = EINVAL;
+		return (-1);
+	}
+	
+	*set |= 1 << sig;
+	
+	return (0);
+}
+
+/*
+ * Deletes a signal from a signal set.
+ */
+int sigdelset(sigset_t *set, int sig)
+{
+	/* Invalid signal. */
+	if (!VALID(sig))
+	{
+		errno = EINVAL;
+		return (-1);
+	}
+	
+	*set &= ~(1 << sig);
+	
+	return (0);
+}
+
+/*
+ * Tests for a signal in a signal set.
+ */
+int sigismember(const sigset_t *set, int sig)
+{
+	/* Invalid signal. */
+	if (!VALID(sig))
+	{
+		errno = EINVAL;
+		return (-1);
+	}
+	
+	return ((*set >> sig) & 1);
+}
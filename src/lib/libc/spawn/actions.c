@@ -0,0 +1,120 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <spawn.h>
+#include <stdlib.h>
+
+/*
+ * Gets a free slot for a file action.
+ */
+static struct spawn_action *getaction
+(posix_spawn_file_actions_t *file_actions, int type, int fd)
+{
+	struct spawn_action *act;
+	
+	if (file_actions->nactions >= SPAWN_ACTIONS_MAX)
+		return (NULL);
+	
+	act = &file_actions->actions[file_actions->nactions++];
+	act->type = type;
+	act->fd = fd;
+	
+	return (act);
+}
+
+/*
+ * Initializes file actions.
+ */
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t *file_actions)
+{
+	file_actions->nactions = 0;
+	
+	return (0);
+}
+
+/*
+ * Destroys file actions.
+ */
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t *file_actions)
+{
+	file_actions->nactions = 0;
+	
+	return (0);
+}
+
+/*
+ * Adds a close action.
+ */
+int posix_spawn_file_actions_addclose
+(posix_spawn_file_actions_t *file_actions, int fd)
+{
+	/* Bad file descriptor. */
+	if ((fd < 0) || (fd >= OPEN_MAX))
+		return (EBADF);
+	
+	if (getaction(file_actions, SPAWN_CLOSE, fd) == NULL)
+		return (ENOMEM);
+	
+	return (0);
+}
+
+/*
+ * Adds a dup2 action.
+ */
+int posix_spawn_file_actions_adddup2
+(posix_spawn_file_actions_t *file_actions, int fd, int newfd)
+{
+	struct spawn_action *act;
+	
+	/* Bad file descriptor. */
+	if ((fd < 0) || (fd >= OPEN_MAX) || (newfd < 0) || (newfd >= OPEN_MAX))
+		return (EBADF);
+	
+	if ((act = getaction(file_actions, SPAWN_DUP2, fd)) == NULL)
+		return (ENOMEM);
+	
+	act->newfd = newfd;
+	
+	return (0);
+}
+
+/*
+ * Adds an open action.
+ */
+int posix_spawn_file_actions_addopen
+(posix_spawn_file_actions_t *file_actions, int fd, const char *path,
+	int oflag, mode_t mode)
+{
+	struct spawn_action *act;
+	
+	/* Bad file descriptor. */
+	if ((fd < 0) || (fd >= OPEN_MAX))
+		return (EBADF);
+	
+	if ((act = getaction(file_actions, SPAWN_OPEN, fd)) == NULL)
+		return (ENOMEM);
+	
+	act->path = path;
+	act->oflag = oflag;
+	act->mode = mode;
+	
+	return (0);
+}
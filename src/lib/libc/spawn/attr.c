@@ -0,0 +1,78 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <spawn.h>
+
+/*
+ * Initializes spawn attributes.
+ */
+int posix_spawnattr_init(posix_spawnattr_t *attr)
+{
+	attr->flags = 0;
+	attr->pgroup = 0;
+	sigemptyset(&attr->sigdefault);
+	
+	return (0);
+}
+
+/*
+ * Destroys spawn attributes.
+ */
+int posix_spawnattr_destroy(posix_spawnattr_t *attr)
+{
+	((void)attr);
+	
+	return (0);
+}
+
+/*
+ * Sets spawn flags.
+ */
+int posix_spawnattr_setflags(posix_spawnattr_t *attr, short flags)
+{
+	/* Invalid flags. */
+	if (flags & ~(POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF))
+		return (EINVAL);
+	
+	attr->flags = flags;
+	
+	return (0);
+}
+
+/*
+ * Sets the process group of the spawned process.
+ */
+int posix_spawnattr_setpgroup(posix_spawnattr_t *attr, pid_t pgroup)
+{
+	attr->pgroup = pgroup;
+	
+	return (0);
+}
+
+/*
+ * Sets signals that are reset to default in the spawned process.
+ */
+int posix_spawnattr_setsigdefault
+(posix_spawnattr_t *attr, const sigset_t *sigdefault)
+{
+	attr->sigdefault = *sigdefault;
+	
+	return (0);
+}
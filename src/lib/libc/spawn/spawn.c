@@ -0,0 +1,214 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * Runs file actions in the child process.
+ */
+static int doactions(const posix_spawn_file_actions_t *file_actions)
+{
+	int fd;                         /* Opened file.    */
+	const struct spawn_action *act; /* Working action. */
+	
+	for (int i = 0; i < file_actions->nactions; i++)
+	{
+		act = &file_actions->actions[i];
+		
+		switch (act->type)
+		{
+			case SPAWN_CLOSE:
+				close(act->fd);
+				break;
+			
+			case SPAWN_DUP2:
+				if (dup2(act->fd, act->newfd) < 0)
+					return (-1);
+				break;
+			
+			case SPAWN_OPEN:
+				close(act->fd);
+				if ((fd = open(act->path, act->oflag, act->mode)) < 0)
+					return (-1);
+				if (fd != act->fd)
+				{
+					if (dup2(fd, act->fd) < 0)
+						return (-1);
+					close(fd);
+				}
+				break;
+		}
+	}
+	
+	return (0);
+}
+
+/*
+ * Sets up the child process as requested.
+ */
+static int setup
+(const posix_spawn_file_actions_t *file_actions, const posix_spawnattr_t *attrp)
+{
+	if (attrp != NULL)
+	{
+		/* Create a new process group. */
+		if (attrp->flags & POSIX_SPAWN_SETPGROUP)
+		{
+			/* Joining another group is not supported. */
+			if (attrp->pgroup != 0)
+			{
+				errno = EINVAL;
+				return (-1);
+			}
+			setpgrp();
+		}
+		
+		/* Reset signals to default. */
+		if (attrp->flags & POSIX_SPAWN_SETSIGDEF)
+		{
+			for (int sig = 1; sig < NR_SIGNALS; sig++)
+			{
+				if (sigismember(&attrp->sigdefault, sig))
+					signal(sig, SIG_DFL);
+			}
+		}
+	}
+	
+	if (file_actions != NULL)
+		return (doactions(file_actions));
+	
+	return (0);
+}
+
+/*
+ * Spawns a process.
+ */
+static int spawn(pid_t *pid, const char *path, const char *file,
+	const posix_spawn_file_actions_t *file_actions,
+	const posix_spawnattr_t *attrp, char *const argv[], char *const envp[])
+{
+	int e;               /* Working error.          */
+	pid_t child;         /* Child process ID.       */
+	volatile int err;    /* Error in child process. */
+	char name[PATH_MAX]; /* Working path name.      */
+	
+	err = 0;
+	
+	/*
+	 * The child borrows our address space, so it must
+	 * not return from here and it reports errors through
+	 * err. We resume only after it has called execve()
+	 * or _exit().
+	 */
+	if ((child = vfork()) < 0)
+		return (errno);
+	
+	/* Child process. */
+	if (child == 0)
+	{
+		if (setup(file_actions, attrp) < 0)
+		{
+			err = errno;
+			_exit(127);
+		}
+		
+		/* Use given path. */
+		if (path != NULL)
+		{
+			execve(path, argv, envp);
+			err = errno;
+			_exit(127);
+		}
+		
+		/* Search for executable. */
+		e = ENOENT;
+		for (const char *p = getenv("PATH"); p != NULL; /* noop */)
+		{
+			const char *q;
+			size_t len;
+			
+			/* Get end of path. */
+			if ((q = strchr(p, ':')) == NULL)
+				q = strchr(p, '\0');
+			
+			/* Build path name. */
+			len = q - p;
+			if (len + strlen(file) + 2 <= PATH_MAX)
+			{
+				memcpy(name, p, len);
+				name[len] = '/';
+				strcpy(&name[len + 1], file);
+				
+				execve(name, argv, envp);
+				
+				/* Remember permission failures. */
+				if (errno != ENOENT)
+					e = errno;
+			}
+			
+			p = (*q == ':') ? q + 1 : NULL;
+		}
+		err = e;
+		_exit(127);
+	}
+	
+	/* The child has already exited, so reap it. */
+	if (err)
+	{
+		waitpid(child, NULL, 0);
+		return (err);
+	}
+	
+	if (pid != NULL)
+		*pid = child;
+	
+	return (0);
+}
+
+/*
+ * Spawns a process.
+ */
+int posix_spawn(pid_t *pid, const char *path,
+	const posix_spawn_file_actions_t *file_actions,
+	const posix_spawnattr_t *attrp, char *const argv[], char *const envp[])
+{
+	return (spawn(pid, path, NULL, file_actions, attrp, argv, envp));
+}
+
+/*
+ * Spawns a process, searching for the executable in PATH.
+ */
+int posix_spawnp(pid_t *pid, const char *file,
+	const posix_spawn_file_actions_t *file_actions,
+	const posix_spawnattr_t *attrp, char *const argv[], char *const envp[])
+{
+	/* Use given path. */
+	if (strchr(file, '/') != NULL)
+		return (spawn(pid, file, NULL, file_actions, attrp, argv, envp));
+	
+	return (spawn(pid, NULL, file, file_actions, attrp, argv, envp));
+}
@@ -24,11 +24,25 @@
  */
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <sys/types.h>
 
+/**
+ * @brief Word that may alias any object.
+ */
+typedef uint32_t __attribute__((__may_alias__)) word_t;
+
+/**
+ * @brief Asserts if a word has a zero byte.
+ */
+#define HASZERO(w) (((w) - 0x01010101) & ~(w) & 0x80808080)
+
 /**
  * @brief Finds a byte in memory.
  * 
+ * @details Skips whole words that do not contain the byte, once the read
+ *          pointer is aligned on a word boundary.
+ * 
  * @param s Where to search from.
  * @param c Byte to be located.
  * @param n Maximum number of bytes to consider.
@@ -40,9 +54,31 @@
  */
 void *memchr(const void *s, int c, size_t n)
 {	
-	const unsigned char *p;
+	const unsigned char *p; /* Read pointer.      */
+	const word_t *w;        /* Word read pointer. */
+	word_t pattern;         /* Search pattern.    */
 			
 	p = s;
+	c = (unsigned char) c;
+	
+	/* Align read pointer. */
+	for (/* noop */; (n > 0) && ((unsigned)p & (sizeof(word_t) - 1)); n--)
+	{
+		if (*p++ == c)
+			return ((void *)(p - 1));
+	}
+	
+	pattern = c*0x01010101;
+	
+	/* Skip words. */
+	for (w = (const word_t *)p; n >= sizeof(word_t); n -= sizeof(word_t))
+	{
+		if (HASZERO(*w ^ pattern))
+			break;
+		w++;
+	}
+	
+	p = (const unsigned char *)w;
 	
 	/* Search byte. */
 	while (n-- > 0)
@@ -53,4 +89,3 @@ void *memchr(const void *s, int c, size_t n)
 	
 	return (NULL);
 }
-
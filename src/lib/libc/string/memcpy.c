@@ -23,11 +23,15 @@
  * @brief memcpy() implementation.
  */
 
+#include <stdint.h>
 #include <sys/types.h>
 
 /**
  * @brief Copies bytes in memory.
  * 
+ * @details Copies the bulk of the object in words, with the target pointer
+ *          aligned on a word boundary, and the remaining bytes one by one.
+ * 
  * @param s1 Pointer to target object.
  * @param s2 Pointer to source object.
  * @param n  Number of bytes to copy.
@@ -39,14 +43,38 @@
  */
 void *memcpy(void *restrict s1, const void *restrict s2, size_t n)
 {
-    char *p1;
-    const char* p2;
-    
-    p1 = s1;
-    p2 = s2;
-    
-    while (n-- > 0)
-    	*p1++ = *p2++;
- 
-    return (p1);
+	char *p1;       /* Write pointer.   */
+	const char *p2; /* Read pointer.    */
+	size_t count;   /* Number of words. */
+	
+	p1 = s1;
+	p2 = s2;
+	
+	/* Copy words. */
+	if (n >= 4*sizeof(uint32_t))
+	{
+		/* Align write pointer. */
+		while ((unsigned)p1 & (sizeof(uint32_t) - 1))
+		{
+			*p1++ = *p2++;
+			n--;
+		}
+		
+		count = n/sizeof(uint32_t);
+		n &= sizeof(uint32_t) - 1;
+		
+		__asm__ volatile (
+			"cld\n"
+			"rep movsl"
+			: "+D" (p1), "+S" (p2), "+c" (count)
+			:
+			: "memory"
+		);
+	}
+	
+	/* Copy remaining bytes. */
+	while (n-- > 0)
+		*p1++ = *p2++;
+	
+	return (s1);
 }
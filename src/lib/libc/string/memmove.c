@@ -56,11 +56,17 @@
  * @brief memmove() implementation.
  */
 
+#include <stdint.h>
 #include <sys/types.h>
 
 /**
  * @brief Copies bytes in memory with overlapping areas.
  * 
+ * @details Copies the bulk of the object in words, with the target pointer
+ *          aligned on a word boundary, and the remaining bytes one by one.
+ *          The copy runs backwards if the target object starts inside the
+ *          source object.
+ * 
  * @param s1 Pointer to target object.
  * @param s2 Pointer to source object.
  * @param n  Number of bytes to copy.
@@ -71,8 +77,9 @@
  */
 void *memmove(void *s1, const void *s2, size_t n)
 {
-	char *p1;
-	const char *p2;
+	char *p1;       /* Write pointer.   */
+	const char *p2; /* Read pointer.    */
+	size_t count;   /* Number of words. */
   
 	p1 = s1;
 	p2 = s2;
@@ -82,12 +89,67 @@ void *memmove(void *s1, const void *s2, size_t n)
 	{
 		p2 += n; p1 += n;
 		
+		/*
+		 * Copy words. Backward string moves take
+		 * longer to start, so only pay off later.
+		 */
+		if (n >= 16*sizeof(uint32_t))
+		{
+			/* Align write pointer. */
+			while ((unsigned)p1 & (sizeof(uint32_t) - 1))
+			{
+				*--p1 = *--p2;
+				n--;
+			}
+			
+			count = n/sizeof(uint32_t);
+			n &= sizeof(uint32_t) - 1;
+			
+			/* Point to last words. */
+			p1 -= sizeof(uint32_t);
+			p2 -= sizeof(uint32_t);
+			
+			__asm__ volatile (
+				"std\n"
+				"rep movsl\n"
+				"cld"
+				: "+D" (p1), "+S" (p2), "+c" (count)
+				:
+				: "memory"
+			);
+			
+			p1 += sizeof(uint32_t);
+			p2 += sizeof(uint32_t);
+		}
+		
 		while (n-- > 0)
 			*--p1 = *--p2;
 	}
 	
 	else
 	{
+		/* Copy words. */
+		if (n >= 4*sizeof(uint32_t))
+		{
+			/* Align write pointer. */
+			while ((unsigned)p1 & (sizeof(uint32_t) - 1))
+			{
+				*p1++ = *p2++;
+				n--;
+			}
+			
+			count = n/sizeof(uint32_t);
+			n &= sizeof(uint32_t) - 1;
+			
+			__asm__ volatile (
+				"cld\n"
+				"rep movsl"
+				: "+D" (p1), "+S" (p2), "+c" (count)
+				:
+				: "memory"
+			);
+		}
+		
 		while (n-- > 0)
 			*p1++ = *p2++;
 	}
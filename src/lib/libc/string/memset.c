@@ -23,11 +23,15 @@
  * @brief memset() implementation.
  */
 
+#include <stdint.h>
 #include <sys/types.h>
 
 /**
  * @brief Sets bytes in memory.
  * 
+ * @details Sets the bulk of the object in words, with the target pointer
+ *          aligned on a word boundary, and the remaining bytes one by one.
+ * 
  * @param s Pointer to target object.
  * @param c Character to copy.
  * @param n Number of bytes to set.
@@ -38,10 +42,39 @@
  */
 void *memset(void *s, int c, size_t n)
 {
-	unsigned char *p;
+	unsigned char *p; /* Write pointer.   */
+	uint32_t pattern; /* Fill pattern.    */
+	size_t count;     /* Number of words. */
 	
 	p = s;
 	
+	/* Set words. */
+	if (n >= 4*sizeof(uint32_t))
+	{
+		/* Align write pointer. */
+		while ((unsigned)p & (sizeof(uint32_t) - 1))
+		{
+			*p++ = c;
+			n--;
+		}
+		
+		pattern = (unsigned char) c;
+		pattern |= pattern << 8;
+		pattern |= pattern << 16;
+		
+		count = n/sizeof(uint32_t);
+		n &= sizeof(uint32_t) - 1;
+		
+		__asm__ volatile (
+			"cld\n"
+			"rep stosl"
+			: "+D" (p), "+c" (count)
+			: "a" (pattern)
+			: "memory"
+		);
+	}
+	
+	/* Set remaining bytes. */
 	while (n-- > 0)
 		*p++ = c;
 	
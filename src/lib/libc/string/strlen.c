@@ -23,11 +23,27 @@
  * @brief strlen() implementation.
  */
 
+#include <stdint.h>
 #include <sys/types.h>
 
+/**
+ * @brief Word that may alias any object.
+ */
+typedef uint32_t __attribute__((__may_alias__)) word_t;
+
+/**
+ * @brief Asserts if a word has a zero byte.
+ */
+#define HASZERO(w) (((w) - 0x01010101) & ~(w) & 0x80808080)
+
 /**
  * @brief Gets string length.
  * 
+ * @details Skips whole words that do not contain the terminating null
+ *          character, once the read pointer is aligned on a word boundary.
+ *          Aligned words never cross a page boundary, so reading past the
+ *          end of the string is safe.
+ * 
  * @param str Target string.
  * 
  * @returns The length of @p str.
@@ -36,10 +52,22 @@
  */
 size_t strlen(const char *str)
 {
-	const char *p;
+	const char *p;   /* Read pointer.      */
+	const word_t *w; /* Word read pointer. */
+	
+	/* Align read pointer. */
+	for (p = str; (unsigned)p & (sizeof(word_t) - 1); p++)
+	{
+		if (*p == '\0')
+			return (p - str);
+	}
+	
+	/* Skip words. */
+	for (w = (const word_t *)p; !HASZERO(*w); w++)
+		/* No operation.*/;
 	
 	/* Count the number of characters. */
-	for (p = str; *p != '\0'; p++)
+	for (p = (const char *)w; *p != '\0'; p++)
 		/* No operation.*/;
 	
 	return (p - str);
@@ -0,0 +1,47 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <nanvix/syscall.h>
+#include <errno.h>
+
+/* Stringifies a constant. */
+#define STR(x) #x
+#define XSTR(x) STR(x)
+
+/*
+ * Creates a new process that borrows the address space of the caller.
+ * 
+ * The child runs on our stack until it calls execve() or _exit(), so
+ * the return address is kept in a register across the system call.
+ */
+__asm__ (
+	".globl vfork\n"
+	"vfork:\n"
+	"	popl %ecx\n"
+	"	movl $" XSTR(NR_vfork) ", %eax\n"
+	"	int $0x80\n"
+	"	pushl %ecx\n"
+	"	testl %eax, %eax\n"
+	"	jns vfork.out\n"
+	"	negl %eax\n"
+	"	movl %eax, errno\n"
+	"	movl $-1, %eax\n"
+	"vfork.out:\n"
+	"	ret\n"
+);
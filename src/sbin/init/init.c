@@ -22,6 +22,7 @@
 #include <sys/wait.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <spawn.h>
 #include <unistd.h>
 #include <stdarg.h>
 #include <stdlib.h>
@@ -133,30 +134,29 @@ static int inittab_read(void)
  */
 static void spawn(int i)
 {
-	inittab[i].pid = fork();
-			
-	/* Failed to fork. */
-	if (inittab[i].pid < 0)
-		return;
-			
-	/* Child process. */
-	if (inittab[i].pid == 0)
-	{
-		const char *cmd;   /* Command.   */
-		const char **args; /* Arguments. */
-		
-		setpgrp();
-		
-		/* Open standard output streams. */
-		open("/dev/tty", O_RDONLY);
-		open("/dev/tty", O_WRONLY);
-		open("/dev/tty", O_WRONLY);
-		
-		/* Execute! */
-		cmd = inittab[i].cmd[0];
-		args = &inittab[i].cmd[1];
-		_exit(execve(cmd, (char *const*)args, (char *const*)environ));
-	}
+	const char *cmd;                   /* Command.            */
+	const char **args;                 /* Arguments.          */
+	posix_spawnattr_t attr;            /* Spawn attributes.   */
+	posix_spawn_file_actions_t action; /* Spawn file actions. */
+	
+	/* Open standard output streams. */
+	posix_spawn_file_actions_init(&action);
+	posix_spawn_file_actions_addopen(&action, 0, "/dev/tty", O_RDONLY, 0);
+	posix_spawn_file_actions_addopen(&action, 1, "/dev/tty", O_WRONLY, 0);
+	posix_spawn_file_actions_addopen(&action, 2, "/dev/tty", O_WRONLY, 0);
+	
+	posix_spawnattr_init(&attr);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+	
+	/* Execute! */
+	cmd = inittab[i].cmd[0];
+	args = &inittab[i].cmd[1];
+	if (posix_spawn(&inittab[i].pid, cmd, &action, &attr,
+		(char *const*)args, (char *const*)environ))
+		inittab[i].pid = -1;
+	
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&action);
 }
 
 /*
@@ -20,6 +20,8 @@
 
 #include <assert.h>
 #include <nanvix/config.h>
+#include <sys/iostat.h>
+#include <sys/mstat.h>
 #include <sys/times.h>
 #include <sys/wait.h>
 #include <sys/sem.h>
@@ -55,6 +57,7 @@ static int swap_test(void)
 	int *a, *b, *c;
 	clock_t t0, t1;
 	struct tms timing;
+	struct mstat ms;
 
 	/* Allocate matrices. */
 	if ((a = malloc(N*N*sizeof(int))) == NULL)
@@ -105,9 +108,17 @@ static int swap_test(void)
 	
 	t1 = times(&timing);
 	
+	if (mstat(&ms) < 0)
+		goto error0;
+	
 	/* Print timing statistics. */
 	if (flags & VERBOSE)
+	{
 		printf("  Elapsed: %d\n", t1 - t0);
+		printf("  Kernel pages: %d/%d\n", ms.ms_kpages_used, ms.ms_kpages);
+		printf("  Kernel pages peak: %d\n", ms.ms_kpages_peak);
+		printf("  Kernel objects: %d\n", ms.ms_objects);
+	}
 	
 	return (0);
 
@@ -121,6 +132,94 @@ error0:
 	return (-1);
 }
 
+/**
+ * @brief Shared pages swapping test module.
+ * 
+ * @details Forks a process that shares a buffer copy on write with its
+ *          parent, and then forces the shared page frames to be paged out
+ *          by touching more memory than there is available.
+ * 
+ * @returns Zero if passed on test, and non-zero otherwise.
+ */
+static int swap_test1(void)
+{
+	#define SHARED_SIZE   (MEMORY_SIZE/8)
+	#define PRESSURE_SIZE (MEMORY_SIZE/2)
+	pid_t pid;
+	int status;
+	char *shared, *p;
+	struct mstat ms0, ms1;
+	
+	if ((shared = malloc(SHARED_SIZE)) == NULL)
+		return (-1);
+	
+	for (int i = 0; i < SHARED_SIZE; i++)
+		shared[i] = i & 0xff;
+	
+	if (mstat(&ms0) < 0)
+		goto error;
+	
+	if ((pid = fork()) < 0)
+		goto error;
+	
+	/* Child process. */
+	if (pid == 0)
+	{
+		/*
+		 * Page tables are shared across fork(), so write
+		 * to the buffer ends to have the pages in between
+		 * mapped by both processes.
+		 */
+		shared[0] = 0;
+		shared[SHARED_SIZE - 1] = (char)((SHARED_SIZE - 1) & 0xff);
+		
+		if ((p = malloc(PRESSURE_SIZE)) == NULL)
+			_exit(EXIT_FAILURE);
+		memset(p, 1, PRESSURE_SIZE);
+		
+		for (int i = 0; i < SHARED_SIZE; i++)
+		{
+			if (shared[i] != (char)(i & 0xff))
+				_exit(EXIT_FAILURE);
+		}
+		
+		_exit(EXIT_SUCCESS);
+	}
+	
+	if (wait(&status) != pid)
+		goto error;
+	if (!WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS))
+		goto error;
+	
+	/* Check values. */
+	for (int i = 0; i < SHARED_SIZE; i++)
+	{
+		if (shared[i] != (char)(i & 0xff))
+			goto error;
+	}
+	
+	if (mstat(&ms1) < 0)
+		goto error;
+	
+	if (flags & VERBOSE)
+	{
+		printf("  Shared frames paged out: %d\n",
+			ms1.ms_shared_out - ms0.ms_shared_out);
+	}
+	
+	/* No shared page frame was reclaimed. */
+	if (ms1.ms_shared_out == ms0.ms_shared_out)
+		goto error;
+	
+	free(shared);
+	
+	return (0);
+
+error:
+	free(shared);
+	return (-1);
+}
+
 /*============================================================================*
  *                                  io_test                                   *
  *============================================================================*/
@@ -135,10 +234,11 @@ error0:
  */
 static int io_test(void)
 {
-	int fd;            /* File descriptor.    */
-	struct tms timing; /* Timing information. */
-	clock_t t0, t1;    /* Elapsed times.      */
-	char *buffer;      /* Buffer.             */
+	int fd;               /* File descriptor.    */
+	struct tms timing;    /* Timing information. */
+	clock_t t0, t1;       /* Elapsed times.      */
+	char *buffer;         /* Buffer.             */
+	struct iostat s0, s1; /* I/O statistics.     */
 	
 	/* Allocate buffer. */
 	buffer = malloc(MEMORY_SIZE);
@@ -150,6 +250,9 @@ static int io_test(void)
 	if (fd < 0)
 		exit(EXIT_FAILURE);
 	
+	if (iostat(ROOT_DEV, &s0) < 0)
+		exit(EXIT_FAILURE);
+	
 	t0 = times(&timing);
 	
 	/* Read hdd. */
@@ -158,13 +261,23 @@ static int io_test(void)
 	
 	t1 = times(&timing);
 	
+	if (iostat(ROOT_DEV, &s1) < 0)
+		exit(EXIT_FAILURE);
+	
 	/* House keeping. */
 	free(buffer);
 	close(fd);
 	
 	/* Print timing statistics. */
 	if (flags & VERBOSE)
+	{
 		printf("  Elapsed: %d\n", t1 - t0);
+		printf("  Requests: %d\n", s1.io_requests - s0.io_requests);
+		printf("  Merged: %d\n", s1.io_merged - s0.io_merged);
+		printf("  Commands: %d\n", s1.io_commands - s0.io_commands);
+		printf("  Seeks: %d\n", s1.io_seeks - s0.io_seeks);
+		printf("  Seeks avoided: %d\n", s1.io_avoided - s0.io_avoided);
+	}
 	
 	return (0);
 }
@@ -605,6 +718,9 @@ int main(int argc, char **argv)
 			printf("Swapping Test\n");
 			printf("  Result:             [%s]\n",
 				(!swap_test()) ? "PASSED" : "FAILED");
+			printf("Shared Pages Swapping Test\n");
+			printf("  Result:             [%s]\n",
+				(!swap_test1()) ? "PASSED" : "FAILED");
 		}
 		
 		/* Scheduling test. */
@@ -27,6 +27,7 @@
 #include <limits.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
@@ -161,10 +162,16 @@ static void closeredir(int *redir)
  */
 static void runcmd(const char **args, int argc, int *redir, int flags)
 {
-	int i;         /* Loop index.       */
-	int status;    /* Exit status.      */
-	pid_t pid;     /* Child process ID. */
-	builtin_t cmd; /* Built-in command. */
+	int i;                             /* Loop index.          */
+	int err;                           /* Error.               */
+	int status;                        /* Exit status.         */
+	pid_t pid;                         /* Child process ID.    */
+	builtin_t cmd;                     /* Built-in command.    */
+	sigset_t sigdef;                   /* Signals to reset.    */
+	sighandler_t sigint_handler;       /* SIGINT handler.      */
+	sighandler_t sigquit_handler;      /* SIGQUIT handler.     */
+	posix_spawnattr_t attr;            /* Spawn attributes.    */
+	posix_spawn_file_actions_t action; /* Spawn file actions.  */
 	
 	/* Checks built-in. */
 	if ((cmd = getbuiltin(args[0])) != NULL)
@@ -175,96 +182,95 @@ static void runcmd(const char **args, int argc, int *redir, int flags)
 		return;
 	}
 	
-	pid = fork();
+	posix_spawn_file_actions_init(&action);
 	
-	/* Failed to fork. */
-	if (pid < 0)
-	{
-		fprintf(stderr, "%s: failed to fork child\n", TSH_NAME);
-		shret = errno;
-		goto error;
-	}
-	
-	/* Parent process. */
-	if (pid > 0)
-	{
-		closeredir(redir);
-		
-		/* Piping... */
-		if (flags & CMD_PIPE)
-			return;
-		
-		/* Asynchronous execution. */
-		if (flags & CMD_ASYNC)
-		{
-			printf("[%d]+\n", pid);
-			return;
-		}
-
-		/* Wait child. */
-		while (wait(&status) != pid)
-			/* noop */;
-		
-		/* Abnormal termination. */
-		if (status != EXIT_SUCCESS)
-		{
-			/* Signal. */
-			if (WIFSIGNALED(status))
-				sigmsg(shret = WTERMSIG(status));
-			
-			/* Voluntary. */
-			else if (WIFEXITED(status))
-				shret = WEXITSTATUS(status);
-			
-			/* Stopped. */
-			else if  (WIFSTOPPED(status))
-				printf("[%d]+\tStopped\n", pid);
-		}
-		
-		return;
-	}
-	
-	/*
-	 * Child process.
-	 */
-
 	/* Reset signals. */
-	signal(SIGINT, SIG_DFL);
-	signal(SIGQUIT, SIG_DFL);
-	signal(SIGTERM, SIG_DFL);
-	signal(SIGTSTP, SIG_DFL);
+	sigemptyset(&sigdef);
+	sigaddset(&sigdef, SIGTERM);
+	sigaddset(&sigdef, SIGTSTP);
+	sigint_handler = sigquit_handler = SIG_DFL;
 	if (flags & CMD_ASYNC)
 	{
-		signal(SIGINT, SIG_IGN);
-		signal(SIGQUIT, SIG_IGN);
+		/* Ignored signals are inherited. */
+		sigint_handler = signal(SIGINT, SIG_IGN);
+		sigquit_handler = signal(SIGQUIT, SIG_IGN);
 		if (redir[0] == -1)
 		{
-			close(0);
-			open("/dev/null", O_RDONLY);
+			posix_spawn_file_actions_addopen(&action, 0, "/dev/null",
+				O_RDONLY, 0);
 		}
 	}
+	else
+	{
+		sigaddset(&sigdef, SIGINT);
+		sigaddset(&sigdef, SIGQUIT);
+	}
+	posix_spawnattr_init(&attr);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+	posix_spawnattr_setsigdefault(&attr, &sigdef);
 	
 	/* Redirections. */
 	for (i = 0; i < 2; i++)
 	{
 		if (redir[i] != -1)
 		{
-			if (dup2(redir[i], i) == -1)
-			{
-				fprintf(stderr, "%s: failed to redirect\n", args[0]);
-				exit(EXIT_FAILURE);
-			}
-			close(redir[i]);
+			posix_spawn_file_actions_adddup2(&action, redir[i], i);
+			posix_spawn_file_actions_addclose(&action, redir[i]);
 		}
 	}
-		
-	execvp(args[0], (char * const *)args);
-	fprintf(stderr, "%s: failed to execute\n", args[0]);
-	exit(EXIT_FAILURE);
-
-error:
-	sherror();
+	
+	err = posix_spawnp(&pid, args[0], &action, &attr,
+		(char * const *)args, environ);
+	
+	/* House keeping. */
+	if (flags & CMD_ASYNC)
+	{
+		signal(SIGINT, sigint_handler);
+		signal(SIGQUIT, sigquit_handler);
+	}
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&action);
 	closeredir(redir);
+	
+	/* Failed to spawn. */
+	if (err)
+	{
+		fprintf(stderr, "%s: failed to execute\n", args[0]);
+		shret = err;
+		sherror();
+		return;
+	}
+	
+	/* Piping... */
+	if (flags & CMD_PIPE)
+		return;
+	
+	/* Asynchronous execution. */
+	if (flags & CMD_ASYNC)
+	{
+		printf("[%d]+\n", pid);
+		return;
+	}
+
+	/* Wait child. */
+	while (wait(&status) != pid)
+		/* noop */;
+	
+	/* Abnormal termination. */
+	if (status != EXIT_SUCCESS)
+	{
+		/* Signal. */
+		if (WIFSIGNALED(status))
+			sigmsg(shret = WTERMSIG(status));
+		
+		/* Voluntary. */
+		else if (WIFEXITED(status))
+			shret = WEXITSTATUS(status);
+		
+		/* Stopped. */
+		else if  (WIFSTOPPED(status))
+			printf("[%d]+\tStopped\n", pid);
+	}
 }
 
 /*
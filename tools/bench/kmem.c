@@ -0,0 +1,315 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host micro-benchmark for the kernel memory routines. It checks kmemcpy(),
+ * kmemset(), kpage_copy() and kpage_zero() against the host libc, and then
+ * reports their speedup over the byte at a time routines they replaced, for
+ * every source/target misalignment and for a range of transfer sizes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Page size.
+ */
+#define PAGE_SIZE 4096
+
+/**
+ * @brief Largest transfer size that is checked byte by byte.
+ */
+#define CHECK_MAX 99
+
+/**
+ * @brief Number of bytes moved in each timed run.
+ */
+#define RUN_BYTES (1 << 22)
+
+/**
+ * @brief Number of timed runs, from which the best one is kept.
+ */
+#define NR_RUNS 3
+
+/* Kernel routines. */
+extern void *kmemcpy(void *, const void *, unsigned);
+extern void *kmemset(void *, int, unsigned);
+extern void kpage_copy(void *, const void *);
+extern void kpage_zero(void *);
+
+/* Reference routines. */
+extern void *ref_kmemcpy(void *, const void *, unsigned);
+extern void *ref_kmemset(void *, int, unsigned);
+
+/**
+ * @brief Transfer sizes that are timed.
+ */
+static const unsigned sizes[] = {
+	1, 3, 8, 15, 16, 17, 32, 63, 64, 99, 256, 1024, PAGE_SIZE
+};
+
+/**
+ * @brief Number of transfer sizes that are timed.
+ */
+#define NR_SIZES (sizeof(sizes)/sizeof(sizes[0]))
+
+/* Working buffers. */
+static unsigned char *src;  /* Source buffer.   */
+static unsigned char *dest; /* Target buffer.   */
+static unsigned char *want; /* Expected buffer. */
+
+/**
+ * @brief Prints an error message and exits.
+ * 
+ * @param what Routine that failed.
+ * @param n    Transfer size.
+ * @param soff Source misalignment.
+ * @param doff Target misalignment.
+ */
+static void fail(const char *what, unsigned n, unsigned soff, unsigned doff)
+{
+	fprintf(stderr, "kmem.bench: %s failed (n=%u, src+%u, dest+%u)\n",
+		what, n, soff, doff);
+	exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Gets the current time, in nanoseconds.
+ */
+static double now(void)
+{
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return (ts.tv_sec*1e9 + ts.tv_nsec);
+}
+
+/**
+ * @brief Checks kmemcpy() and kmemset().
+ * 
+ * @details Every source/target misalignment and every size up to CHECK_MAX
+ *          is checked, and so are the bytes around the target area.
+ */
+static void check(void)
+{
+	for (unsigned n = 0; n <= CHECK_MAX; n++)
+	{
+		for (unsigned soff = 0; soff < 4; soff++)
+		{
+			for (unsigned doff = 0; doff < 4; doff++)
+			{
+				memset(dest, 0xaa, CHECK_MAX + 8);
+				memcpy(want, dest, CHECK_MAX + 8);
+				memcpy(want + doff, src + soff, n);
+				if (kmemcpy(dest + doff, src + soff, n) != dest + doff)
+					fail("kmemcpy", n, soff, doff);
+				if (memcmp(dest, want, CHECK_MAX + 8))
+					fail("kmemcpy", n, soff, doff);
+			}
+		}
+		
+		for (unsigned doff = 0; doff < 4; doff++)
+		{
+			memset(dest, 0xaa, CHECK_MAX + 8);
+			memcpy(want, dest, CHECK_MAX + 8);
+			memset(want + doff, 0x5c, n);
+			if (kmemset(dest + doff, 0x15c, n) != dest + doff)
+				fail("kmemset", n, 0, doff);
+			if (memcmp(dest, want, CHECK_MAX + 8))
+				fail("kmemset", n, 0, doff);
+		}
+	}
+	
+	memset(dest, 0xaa, PAGE_SIZE);
+	kpage_copy(dest, src);
+	if (memcmp(dest, src, PAGE_SIZE))
+		fail("kpage_copy", PAGE_SIZE, 0, 0);
+	
+	kpage_zero(dest);
+	memset(want, 0, PAGE_SIZE);
+	if (memcmp(dest, want, PAGE_SIZE))
+		fail("kpage_zero", PAGE_SIZE, 0, 0);
+}
+
+/**
+ * @brief Times a copy routine.
+ * 
+ * @param copy Copy routine.
+ * @param n    Transfer size.
+ * @param soff Source misalignment.
+ * @param doff Target misalignment.
+ * 
+ * @returns The time per call, in nanoseconds.
+ */
+static double time_copy
+(void *(*copy)(void *, const void *, unsigned),
+ unsigned n, unsigned soff, unsigned doff)
+{
+	double best;     /* Best run.         */
+	unsigned nreps;  /* Calls in one run. */
+	
+	nreps = RUN_BYTES/n;
+	
+	best = 0;
+	for (unsigned r = 0; r < NR_RUNS; r++)
+	{
+		double t;
+		
+		t = now();
+		for (unsigned i = 0; i < nreps; i++)
+			copy(dest + doff, src + soff, n);
+		t = now() - t;
+		
+		if ((r == 0) || (t < best))
+			best = t;
+	}
+	
+	return (best/nreps);
+}
+
+/**
+ * @brief Times a set routine.
+ * 
+ * @param set  Set routine.
+ * @param n    Transfer size.
+ * @param doff Target misalignment.
+ * 
+ * @returns The time per call, in nanoseconds.
+ */
+static double time_set
+(void *(*set)(void *, int, unsigned), unsigned n, unsigned doff)
+{
+	double best;     /* Best run.         */
+	unsigned nreps;  /* Calls in one run. */
+	
+	nreps = RUN_BYTES/n;
+	
+	best = 0;
+	for (unsigned r = 0; r < NR_RUNS; r++)
+	{
+		double t;
+		
+		t = now();
+		for (unsigned i = 0; i < nreps; i++)
+			set(dest + doff, (int) i, n);
+		t = now() - t;
+		
+		if ((r == 0) || (t < best))
+			best = t;
+	}
+	
+	return (best/nreps);
+}
+
+/**
+ * @brief Wrapper that copies a page with kpage_copy().
+ */
+static void *page_copy(void *d, const void *s, unsigned n)
+{
+	((void) n);
+	
+	kpage_copy(d, s);
+	
+	return (d);
+}
+
+/**
+ * @brief Wrapper that zeroes a page with kpage_zero().
+ */
+static void *page_zero(void *p, int c, unsigned n)
+{
+	((void) c);
+	((void) n);
+	
+	kpage_zero(p);
+	
+	return (p);
+}
+
+/**
+ * @brief Benchmarks the kernel memory routines.
+ */
+int main(void)
+{
+	double t0, t1; /* Reference and kernel times. */
+	
+	if (posix_memalign((void **)&src, PAGE_SIZE, 2*PAGE_SIZE) ||
+		posix_memalign((void **)&dest, PAGE_SIZE, 2*PAGE_SIZE) ||
+		posix_memalign((void **)&want, PAGE_SIZE, 2*PAGE_SIZE))
+	{
+		fprintf(stderr, "kmem.bench: out of memory\n");
+		return (EXIT_FAILURE);
+	}
+	
+	for (unsigned i = 0; i < 2*PAGE_SIZE; i++)
+		src[i] = (unsigned char) (i*7 + 1);
+	
+	check();
+	printf("kmemcpy(), kmemset(), kpage_copy(), kpage_zero(): ok\n\n");
+	
+	printf("kmemcpy() speedup over byte copy\n");
+	printf("%6s %5s |%8s%8s%8s%8s\n",
+		"size", "src", "dest+0", "dest+1", "dest+2", "dest+3");
+	for (unsigned i = 0; i < NR_SIZES; i++)
+	{
+		for (unsigned soff = 0; soff < 4; soff++)
+		{
+			printf("%6u %3s+%u |", sizes[i], "", soff);
+			for (unsigned doff = 0; doff < 4; doff++)
+			{
+				t0 = time_copy(ref_kmemcpy, sizes[i], soff, doff);
+				t1 = time_copy(kmemcpy, sizes[i], soff, doff);
+				printf("%7.2fx", t0/t1);
+			}
+			printf("\n");
+		}
+	}
+	
+	printf("\nkmemset() speedup over byte set\n");
+	printf("%6s %5s |%8s%8s%8s%8s\n",
+		"size", "", "dest+0", "dest+1", "dest+2", "dest+3");
+	for (unsigned i = 0; i < NR_SIZES; i++)
+	{
+		printf("%6u %5s |", sizes[i], "");
+		for (unsigned doff = 0; doff < 4; doff++)
+		{
+			t0 = time_set(ref_kmemset, sizes[i], doff);
+			t1 = time_set(kmemset, sizes[i], doff);
+			printf("%7.2fx", t0/t1);
+		}
+		printf("\n");
+	}
+	
+	printf("\nWhole page speedup over byte routines\n");
+	t0 = time_copy(ref_kmemcpy, PAGE_SIZE, 0, 0);
+	t1 = time_copy(page_copy, PAGE_SIZE, 0, 0);
+	printf("%12s: %7.2fx (%.0f ns -> %.0f ns)\n", "kpage_copy", t0/t1, t0, t1);
+	t0 = time_set(ref_kmemset, PAGE_SIZE, 0);
+	t1 = time_set(page_zero, PAGE_SIZE, 0);
+	printf("%12s: %7.2fx (%.0f ns -> %.0f ns)\n", "kpage_zero", t0/t1, t0, t1);
+	
+	free(want);
+	free(dest);
+	free(src);
+	
+	return (EXIT_SUCCESS);
+}
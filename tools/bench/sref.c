@@ -0,0 +1,149 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Reference routines for the string benchmark. These are the byte at a
+ * time memcpy(), memset(), memmove(), strlen() and memchr() that the C
+ * library used before the word at a time ones, and they are built with the
+ * same flags as the routines they are compared against.
+ */
+
+#include <stdlib.h>
+#include <sys/types.h>
+
+/**
+ * @brief Copies bytes in memory, one byte at a time.
+ * 
+ * @param s1 Target memory area.
+ * @param s2 Source memory area.
+ * @param n  Number of bytes to be copied.
+ * 
+ * @returns A pointer to the target memory area.
+ */
+void *ref_memcpy(void *s1, const void *s2, size_t n)
+{
+	char *p1;       /* Write pointer. */
+	const char *p2; /* Read pointer.  */
+	
+	p1 = s1;
+	p2 = s2;
+	
+	while (n-- > 0)
+		*p1++ = *p2++;
+	
+	return (s1);
+}
+
+/**
+ * @brief Sets bytes in memory, one byte at a time.
+ * 
+ * @param s Target memory area.
+ * @param c Character to use.
+ * @param n Number of bytes to be set.
+ * 
+ * @returns A pointer to the target memory area.
+ */
+void *ref_memset(void *s, int c, size_t n)
+{
+	unsigned char *p; /* Write pointer. */
+	
+	p = s;
+	
+	while (n-- > 0)
+		*p++ = c;
+	
+	return (s);
+}
+
+/**
+ * @brief Moves bytes in memory, one byte at a time.
+ * 
+ * @param s1 Target memory area.
+ * @param s2 Source memory area.
+ * @param n  Number of bytes to be moved.
+ * 
+ * @returns A pointer to the target memory area.
+ */
+void *ref_memmove(void *s1, const void *s2, size_t n)
+{
+	char *p1;       /* Write pointer. */
+	const char *p2; /* Read pointer.  */
+	
+	p1 = s1;
+	p2 = s2;
+	
+	/* Have to copy backwards */
+	if (p2 < p1 && p1 < p2 + n)
+	{
+		p2 += n; p1 += n;
+		
+		while (n-- > 0)
+			*--p1 = *--p2;
+	}
+	
+	else
+	{
+		while (n-- > 0)
+			*p1++ = *p2++;
+	}
+	
+	return (s1);
+}
+
+/**
+ * @brief Returns the length of a string, one byte at a time.
+ * 
+ * @param str String.
+ * 
+ * @returns The length of the string.
+ */
+size_t ref_strlen(const char *str)
+{
+	const char *p; /* Read pointer. */
+	
+	for (p = str; *p != '\0'; p++)
+		/* No operation.*/;
+	
+	return (p - str);
+}
+
+/**
+ * @brief Searches for a byte in memory, one byte at a time.
+ * 
+ * @param s Memory area.
+ * @param c Byte to search for.
+ * @param n Number of bytes to search.
+ * 
+ * @returns A pointer to the byte that was found, or NULL if none.
+ */
+void *ref_memchr(const void *s, int c, size_t n)
+{
+	const unsigned char *p; /* Read pointer. */
+	
+	p = s;
+	c = (unsigned char) c;
+	
+	while (n-- > 0)
+	{
+		if (*p++ == c)
+			return ((void *)(p - 1));
+	}
+	
+	return (NULL);
+}
@@ -0,0 +1,427 @@
+/*
+ * Copyright(C) 2011-2016 Pedro H. Penna <pedrohenriquepenna@gmail.com>
+ * 
+ * This file is part of Nanvix.
+ * 
+ * Nanvix is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Nanvix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Nanvix. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host test suite and benchmark for the string routines of the C library.
+ * It checks memcpy(), memset(), memmove(), strlen() and memchr() against
+ * the host libc, and then reports their throughput next to the byte at a
+ * time routines they replaced, for small and large sizes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Page size.
+ */
+#define PAGE_SIZE 4096
+
+/**
+ * @brief Largest size that is checked byte by byte.
+ */
+#define CHECK_MAX 119
+
+/**
+ * @brief Largest size that is timed.
+ */
+#define SIZE_MAX_BENCH (1 << 16)
+
+/**
+ * @brief Size of working buffers.
+ */
+#define BUF_SIZE (2*SIZE_MAX_BENCH + PAGE_SIZE)
+
+/**
+ * @brief Number of bytes touched in each timed run.
+ */
+#define RUN_BYTES (1 << 22)
+
+/**
+ * @brief Number of timed runs, from which the best one is kept.
+ */
+#define NR_RUNS 3
+
+/* C library routines. */
+extern void *nx_memcpy(void *, const void *, unsigned);
+extern void *nx_memset(void *, int, unsigned);
+extern void *nx_memmove(void *, const void *, unsigned);
+extern unsigned nx_strlen(const char *);
+extern void *nx_memchr(const void *, int, unsigned);
+
+/* Reference routines. */
+extern void *ref_memcpy(void *, const void *, unsigned);
+extern void *ref_memset(void *, int, unsigned);
+extern void *ref_memmove(void *, const void *, unsigned);
+extern unsigned ref_strlen(const char *);
+extern void *ref_memchr(const void *, int, unsigned);
+
+/**
+ * @brief Sizes that are timed.
+ */
+static const unsigned sizes[] = {
+	4, 8, 16, 32, 64, 128, 256, 1024, PAGE_SIZE, SIZE_MAX_BENCH
+};
+
+/**
+ * @brief Number of sizes that are timed.
+ */
+#define NR_SIZES (sizeof(sizes)/sizeof(sizes[0]))
+
+/* Working buffers. */
+static unsigned char *src;  /* Source buffer.   */
+static unsigned char *dest; /* Target buffer.   */
+static unsigned char *want; /* Expected buffer. */
+
+/**
+ * @brief Number of failed checks.
+ */
+static unsigned nfailed = 0;
+
+/**
+ * @brief Records a failed check.
+ * 
+ * @param what Routine that failed.
+ * @param n    Size.
+ * @param off1 First offset.
+ * @param off2 Second offset.
+ */
+static void fail(const char *what, unsigned n, int off1, int off2)
+{
+	if (nfailed++ < 16)
+	{
+		fprintf(stderr, "string.bench: %s failed (n=%u, %d, %d)\n",
+			what, n, off1, off2);
+	}
+}
+
+/**
+ * @brief Checks memcpy() and memset().
+ * 
+ * @details Every source/target misalignment and every size up to CHECK_MAX
+ *          is checked, and so are the bytes around the target area.
+ */
+static void check_memcpy_memset(void)
+{
+	for (unsigned n = 0; n <= CHECK_MAX; n++)
+	{
+		for (int soff = 0; soff < 4; soff++)
+		{
+			for (int doff = 0; doff < 4; doff++)
+			{
+				memset(dest, 0xaa, CHECK_MAX + 8);
+				memcpy(want, dest, CHECK_MAX + 8);
+				memcpy(want + doff, src + soff, n);
+				if (nx_memcpy(dest + doff, src + soff, n) != dest + doff)
+					fail("memcpy", n, soff, doff);
+				else if (memcmp(dest, want, CHECK_MAX + 8))
+					fail("memcpy", n, soff, doff);
+			}
+		}
+		
+		for (int doff = 0; doff < 4; doff++)
+		{
+			memset(dest, 0xaa, CHECK_MAX + 8);
+			memcpy(want, dest, CHECK_MAX + 8);
+			memset(want + doff, 0x5c, n);
+			if (nx_memset(dest + doff, 0x15c, n) != dest + doff)
+				fail("memset", n, doff, 0);
+			else if (memcmp(dest, want, CHECK_MAX + 8))
+				fail("memset", n, doff, 0);
+		}
+	}
+}
+
+/**
+ * @brief Checks memmove().
+ * 
+ * @details Every source misalignment, every size up to CHECK_MAX and every
+ *          distance between source and target that makes them overlap, in
+ *          both directions, is checked. So are some distances that do not.
+ */
+static void check_memmove(void)
+{
+	unsigned char *base; /* Base of source area. */
+	
+	base = dest + 2*CHECK_MAX;
+	
+	for (unsigned n = 0; n <= CHECK_MAX; n++)
+	{
+		for (int soff = 0; soff < 4; soff++)
+		{
+			for (int dist = -(int)n - 4; dist <= (int)n + 4; dist++)
+			{
+				unsigned char *s = base + soff;
+				unsigned char *d = base + soff + dist;
+				
+				memcpy(dest, src, 5*CHECK_MAX);
+				memcpy(want, src, 5*CHECK_MAX);
+				memmove(want + (d - dest), want + (s - dest), n);
+				if (nx_memmove(d, s, n) != d)
+					fail("memmove", n, soff, dist);
+				else if (memcmp(dest, want, 5*CHECK_MAX))
+					fail("memmove", n, soff, dist);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Checks strlen().
+ * 
+ * @details For every misalignment of the string, the terminating null
+ *          character is placed at every offset up to CHECK_MAX. Bytes that
+ *          trip naive zero-byte tests are placed around it.
+ */
+static void check_strlen(void)
+{
+	static const unsigned char tricky[] = { 0x80, 0x01, 0xff, 0x7f, 0x81 };
+	
+	for (int off = 0; off < 4; off++)
+	{
+		for (unsigned n = 0; n <= CHECK_MAX; n++)
+		{
+			for (unsigned i = 0; i < CHECK_MAX + 8; i++)
+				dest[i] = tricky[(i + n) % sizeof(tricky)];
+			dest[off + n] = '\0';
+			
+			if (nx_strlen((const char *)dest + off) != n)
+				fail("strlen", n, off, 0);
+		}
+	}
+}
+
+/**
+ * @brief Checks memchr().
+ * 
+ * @details For every misalignment of the memory area and every size up to
+ *          CHECK_MAX, the byte searched for is placed at every offset, and
+ *          also right past the end of the area. Every byte value is searched
+ *          for, passed both as is and with bits set above the low byte.
+ */
+static void check_memchr(void)
+{
+	for (int off = 0; off < 4; off++)
+	{
+		for (unsigned n = 0; n <= CHECK_MAX; n++)
+		{
+			for (unsigned pos = 0; pos <= n; pos++)
+			{
+				int c = (n*7 + pos) & 0xff;
+				
+				/* Other bytes differ from c by a single bit. */
+				for (unsigned i = 0; i < CHECK_MAX + 8; i++)
+					dest[i] = c ^ (1 << (i & 7));
+				dest[off + pos] = c;
+				
+				if (nx_memchr(dest + off, c, n) !=
+					((pos < n) ? dest + off + pos : NULL))
+					fail("memchr", n, off, pos);
+				if (nx_memchr(dest + off, c | 0x300, n) !=
+					((pos < n) ? dest + off + pos : NULL))
+					fail("memchr", n, off, pos);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Gets the current time, in nanoseconds.
+ */
+static double now(void)
+{
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return (ts.tv_sec*1e9 + ts.tv_nsec);
+}
+
+/**
+ * @brief Routine under test, with a common signature.
+ */
+typedef void (*routine_t)(unsigned char *, unsigned char *, unsigned);
+
+/* Sink for results that would otherwise be discarded. */
+static volatile unsigned long sink;
+
+/*
+ * Wrappers with a common signature. Reference and C library routines get
+ * the same wrapper, so the call overhead is the same for both.
+ */
+static void ref_cpy(unsigned char *d, unsigned char *s, unsigned n)
+	{ ref_memcpy(d, s, n); }
+static void nx_cpy(unsigned char *d, unsigned char *s, unsigned n)
+	{ nx_memcpy(d, s, n); }
+static void ref_set(unsigned char *d, unsigned char *s, unsigned n)
+	{ ((void) s); ref_memset(d, n, n); }
+static void nx_set(unsigned char *d, unsigned char *s, unsigned n)
+	{ ((void) s); nx_memset(d, n, n); }
+static void ref_mov(unsigned char *d, unsigned char *s, unsigned n)
+	{ ref_memmove(d, s, n); }
+static void nx_mov(unsigned char *d, unsigned char *s, unsigned n)
+	{ nx_memmove(d, s, n); }
+static void ref_len(unsigned char *d, unsigned char *s, unsigned n)
+	{ ((void) d); ((void) n); sink += ref_strlen((const char *)s); }
+static void nx_len(unsigned char *d, unsigned char *s, unsigned n)
+	{ ((void) d); ((void) n); sink += nx_strlen((const char *)s); }
+static void ref_chr(unsigned char *d, unsigned char *s, unsigned n)
+	{ ((void) d); sink += (ref_memchr(s, 0, n) != NULL); }
+static void nx_chr(unsigned char *d, unsigned char *s, unsigned n)
+	{ ((void) d); sink += (nx_memchr(s, 0, n) != NULL); }
+
+/**
+ * @brief Benchmark.
+ */
+struct bench
+{
+	const char *name; /**< Name.                       */
+	routine_t ref;    /**< Reference routine.          */
+	routine_t nx;     /**< C library routine.          */
+	int doff;         /**< Target offset, from source. */
+};
+
+/**
+ * @brief Benchmarks.
+ */
+static const struct bench benches[] = {
+	{ "memcpy",        ref_cpy, nx_cpy, SIZE_MAX_BENCH + 8 },
+	{ "memset",        ref_set, nx_set, 0                  },
+	{ "memmove (fwd)", ref_mov, nx_mov, -8                 },
+	{ "memmove (bwd)", ref_mov, nx_mov, 8                  },
+	{ "strlen",        ref_len, nx_len, 0                  },
+	{ "memchr",        ref_chr, nx_chr, 0                  },
+};
+
+/**
+ * @brief Number of benchmarks.
+ */
+#define NR_BENCHES (sizeof(benches)/sizeof(benches[0]))
+
+/**
+ * @brief Times a routine.
+ * 
+ * @param routine Routine.
+ * @param d       Target area.
+ * @param s       Source area.
+ * @param n       Size.
+ * 
+ * @returns The throughput, in MB/s.
+ */
+static double throughput
+(routine_t routine, unsigned char *d, unsigned char *s, unsigned n)
+{
+	double best;    /* Best run.         */
+	unsigned nreps; /* Calls in one run. */
+	
+	nreps = RUN_BYTES/n;
+	
+	best = 0;
+	for (unsigned r = 0; r < NR_RUNS; r++)
+	{
+		double t;
+		
+		t = now();
+		for (unsigned i = 0; i < nreps; i++)
+			routine(d, s, n);
+		t = now() - t;
+		
+		if ((r == 0) || (t < best))
+			best = t;
+	}
+	
+	return ((1e3*nreps*n)/best);
+}
+
+/**
+ * @brief Runs a benchmark.
+ * 
+ * @details Each size is timed with an aligned source and with the source one
+ *          byte past an alignment boundary.
+ * 
+ * @param b Benchmark.
+ */
+static void bench(const struct bench *b)
+{
+	printf("\n%s\n", b->name);
+	printf("%6s |%10s%10s%9s |%10s%10s%9s\n", "size",
+		"old MB/s", "new MB/s", "aligned",
+		"old MB/s", "new MB/s", "src+1");
+	
+	for (unsigned i = 0; i < NR_SIZES; i++)
+	{
+		unsigned n = sizes[i];
+		
+		printf("%6u |", n);
+		for (int off = 0; off < 2; off++)
+		{
+			unsigned char *s = src + PAGE_SIZE/2 + off;
+			unsigned char *d = s + b->doff;
+			double t0, t1;
+			
+			/* No null character and no match before the end. */
+			for (unsigned j = 0; j < BUF_SIZE; j++)
+				src[j] = 'a' + j % 26;
+			s[n] = '\0';
+			
+			t0 = throughput(b->ref, d, s, n);
+			t1 = throughput(b->nx, d, s, n);
+			printf("%10.0f%10.0f%8.2fx", t0, t1, t1/t0);
+			printf((off == 0) ? " |" : "\n");
+		}
+	}
+}
+
+/**
+ * @brief Tests and benchmarks the string routines of the C library.
+ */
+int main(void)
+{
+	if (posix_memalign((void **)&src, PAGE_SIZE, BUF_SIZE) ||
+		posix_memalign((void **)&dest, PAGE_SIZE, BUF_SIZE) ||
+		posix_memalign((void **)&want, PAGE_SIZE, BUF_SIZE))
+	{
+		fprintf(stderr, "string.bench: out of memory\n");
+		return (EXIT_FAILURE);
+	}
+	
+	for (unsigned i = 0; i < BUF_SIZE; i++)
+		src[i] = (unsigned char) (i*7 + 1);
+	
+	check_memcpy_memset();
+	check_memmove();
+	check_strlen();
+	check_memchr();
+	if (nfailed > 0)
+	{
+		fprintf(stderr, "string.bench: %u checks failed\n", nfailed);
+		return (EXIT_FAILURE);
+	}
+	printf("memcpy(), memset(), memmove(), strlen(), memchr(): ok\n");
+	
+	for (unsigned i = 0; i < NR_BENCHES; i++)
+		bench(&benches[i]);
+	
+	free(want);
+	free(dest);
+	free(src);
+	
+	return (EXIT_SUCCESS);
+}
@@ -342,6 +342,252 @@ static block_t minix_block_map(struct d_inode *ip, off_t off, bool create)
 	return (BLOCK_NULL);
 }
 
+/**
+ * @brief Number of hash buckets of a newly hashed directory.
+ */
+#define DINDEX_MIN 2
+
+/**
+ * @brief Number of directory entries in a block.
+ */
+#define DIRENTS_PER_BLOCK (BLOCK_SIZE/sizeof(struct d_dirent))
+
+/**
+ * @brief Gets the number of hash buckets of a directory.
+ * 
+ * @param ip Directory.
+ * 
+ * @returns The number of hash buckets of the directory pointed to by @p ip,
+ *          or zero if the directory is not hashed.
+ * 
+ * @note @p ip must point to a valid inode.
+ * @note The Minix file system must be mounted.
+ */
+static unsigned dindex_get(struct d_inode *ip)
+{
+	struct d_dindex x; /* Directory index. */
+	
+	/* Too small to be hashed. */
+	if ((ip->i_size < 2*BLOCK_SIZE) || (ip->i_zones[0] == BLOCK_NULL))
+		return (0);
+	
+	slseek(fd, ip->i_zones[0]*BLOCK_SIZE + DINDEX_SLOT*sizeof(x), SEEK_SET);
+	sread(fd, &x, sizeof(struct d_dindex));
+	
+	if ((x.d_ino != INODE_NULL) || (x.d_magic != DINDEX_MAGIC))
+		return (0);
+	
+	/* Expanded by someone that does not know about the index. */
+	if ((x.d_nbuckets + 1u)*BLOCK_SIZE != ip->i_size)
+		return (0);
+	
+	return (x.d_nbuckets);
+}
+
+/**
+ * @brief Drops the index of a hashed directory.
+ * 
+ * @param ip Directory.
+ * 
+ * @note @p ip must point to a valid hashed directory.
+ * @note The Minix file system must be mounted.
+ */
+static void dindex_drop(struct d_inode *ip)
+{
+	struct d_dindex x; /* Directory index. */
+	
+	memset(&x, 0, sizeof(struct d_dindex));
+	slseek(fd, ip->i_zones[0]*BLOCK_SIZE + DINDEX_SLOT*sizeof(x), SEEK_SET);
+	swrite(fd, &x, sizeof(struct d_dindex));
+}
+
+/**
+ * @brief Hashes a directory.
+ * 
+ * @param ip Directory.
+ * @param n  Minimum number of hash buckets.
+ * 
+ * @returns The number of hash buckets of the directory, or zero if the
+ *          directory cannot be hashed. In the later case, the directory is
+ *          left as a linear one.
+ * 
+ * @note @p ip must point to a valid inode.
+ * @note The Minix file system must be mounted.
+ */
+static unsigned dindex_build(struct d_inode *ip, unsigned n)
+{
+	block_t blk;             /* Working block.          */
+	unsigned nblocks;        /* Number of blocks.       */
+	unsigned *count;         /* Entries in each bucket. */
+	struct d_dirent *d;      /* All directory entries.  */
+	struct d_dindex *x;      /* Directory index.        */
+	struct d_dirent *bucket; /* Working bucket.         */
+	
+	nblocks = (ip->i_size + BLOCK_SIZE - 1)/BLOCK_SIZE;
+	if (n + 1 < nblocks)
+		n = nblocks - 1;
+	
+	/* Read all directory entries. */
+	d = scalloc(nblocks, BLOCK_SIZE);
+	for (unsigned i = 0; i < nblocks; i++)
+	{
+		blk = minix_block_map(ip, i*BLOCK_SIZE, false);
+		if (blk == BLOCK_NULL)
+			continue;
+		
+		slseek(fd, blk*BLOCK_SIZE, SEEK_SET);
+		sread(fd, &d[i*DIRENTS_PER_BLOCK], BLOCK_SIZE);
+	}
+	for (unsigned i = ip->i_size/sizeof(struct d_dirent);
+	     i < nblocks*DIRENTS_PER_BLOCK;
+	     i++)
+		d[i].d_ino = INODE_NULL;
+	
+	/* Choose number of buckets. */
+	count = NULL;
+again:
+	free(count);
+	if (n > DINDEX_MAX)
+	{
+		free(d);
+		return (0);
+	}
+	count = scalloc(n, sizeof(unsigned));
+	for (unsigned i = DINDEX_SLOT; i < nblocks*DIRENTS_PER_BLOCK; i++)
+	{
+		if (d[i].d_ino == INODE_NULL)
+			continue;
+		
+		if (++count[dindex_hash(d[i].d_name)%n] > DIRENTS_PER_BLOCK)
+		{
+			n <<= 1;
+			goto again;
+		}
+	}
+	
+	ip->i_size = (n + 1)*BLOCK_SIZE;
+	
+	/* Write buckets. */
+	bucket = smalloc(BLOCK_SIZE);
+	for (unsigned i = 0; i < n; i++)
+	{
+		unsigned j = 0;
+		
+		memset(bucket, 0, BLOCK_SIZE);
+		for (unsigned k = DINDEX_SLOT; k < nblocks*DIRENTS_PER_BLOCK; k++)
+		{
+			if (d[k].d_ino == INODE_NULL)
+				continue;
+			if (dindex_hash(d[k].d_name)%n != i)
+				continue;
+			
+			bucket[j++] = d[k];
+		}
+		
+		blk = minix_block_map(ip, (i + 1)*BLOCK_SIZE, true);
+		slseek(fd, blk*BLOCK_SIZE, SEEK_SET);
+		swrite(fd, bucket, BLOCK_SIZE);
+	}
+	
+	/* Write first block. */
+	memset(bucket, 0, BLOCK_SIZE);
+	memcpy(bucket, d, DINDEX_SLOT*sizeof(struct d_dirent));
+	x = (struct d_dindex *)&bucket[DINDEX_SLOT];
+	x->d_magic = DINDEX_MAGIC;
+	x->d_nbuckets = n;
+	slseek(fd, ip->i_zones[0]*BLOCK_SIZE, SEEK_SET);
+	swrite(fd, bucket, BLOCK_SIZE);
+	
+	free(bucket);
+	free(count);
+	free(d);
+	
+	return (n);
+}
+
+/**
+ * @brief Searches for a directory entry in a block.
+ * 
+ * @param blk      Block.
+ * @param filename Name of the directory entry that shall be searched.
+ * @param avail    Place to store the file offset of the first free entry.
+ * 
+ * @returns The file offset where the directory entry is located, or -1 if
+ *          the entry does not exist in the block.
+ * 
+ * @note The Minix file system must be mounted.
+ */
+static off_t dirent_scan(block_t blk, const char *filename, off_t *avail)
+{
+	off_t base;                           /* Block offset.      */
+	struct d_dirent d[DIRENTS_PER_BLOCK]; /* Directory entries. */
+	
+	base = blk*BLOCK_SIZE;
+	slseek(fd, base, SEEK_SET);
+	sread(fd, d, BLOCK_SIZE);
+	
+	for (unsigned i = 0; i < DIRENTS_PER_BLOCK; i++)
+	{
+		/* Remember free entry. */
+		if (d[i].d_ino == INODE_NULL)
+		{
+			if ((avail != NULL) && (*avail < 0))
+				*avail = base + i*sizeof(struct d_dirent);
+			continue;
+		}
+		
+		/* Found. */
+		if (!strncmp(d[i].d_name, filename, MINIX_NAME_MAX))
+			return (base + i*sizeof(struct d_dirent));
+	}
+	
+	return (-1);
+}
+
+/**
+ * @brief Searches for a directory entry in a hashed directory.
+ * 
+ * @param ip       Directory where the directory entry shall be searched. 
+ * @param n        Number of hash buckets of the directory.
+ * @param filename Name of the directory entry that shall be searched.
+ * @param create   Create directory entry?
+ * 
+ * @returns The file offset where the directory entry is located, or -1 if the
+ *          file does not exist or, when @p create is set, if its bucket is
+ *          full.
+ * 
+ * @note @p ip must point to a valid inode
+ * @note @p filename must point to a valid file name.
+ * @note The Minix file system must be mounted.
+ */
+static off_t dirent_hashed
+(struct d_inode *ip, unsigned n, const char *filename, bool create)
+{
+	off_t off;   /* File offset of the entry.  */
+	off_t avail; /* File offset of free entry. */
+	block_t blk; /* Bucket.                    */
+	
+	/* "." and ".." live in the first block. */
+	off = dirent_scan(ip->i_zones[0], filename, NULL);
+	
+	if (off < 0)
+	{
+		off = (dindex_hash(filename)%n + 1)*BLOCK_SIZE;
+		blk = minix_block_map(ip, off, false);
+		avail = -1;
+		off = dirent_scan(blk, filename, &avail);
+		
+		if (off < 0)
+			return ((create) ? avail : -1);
+	}
+	
+	/* Duplicate entry. */
+	if (create)
+		error("duplicate entry");
+	
+	return (off);
+}
+
 /**
  * @brief Searches for a directory entry.
  * 
@@ -364,6 +610,24 @@ static off_t dirent_search(struct d_inode *ip, const char *filename,bool create)
 	block_t blk;       /* Working block.               */
 	int nentries;      /* Number of directory entries. */
 	struct d_dirent d; /* Working directory entry.     */
+	unsigned n;        /* Number of hash buckets.      */
+	
+	n = dindex_get(ip);
+	
+	/* Hashed directory. */
+	if (n > 0)
+	{
+		off = dirent_hashed(ip, n, filename, create);
+		if ((off >= 0) || (!create))
+			return (off);
+		
+		/* Bucket is full, so rehash directory. */
+		if (dindex_build(ip, 2*n) > 0)
+			return (dirent_search(ip, filename, create));
+		
+		/* Too many buckets, so fallback to a linear directory. */
+		dindex_drop(ip);
+	}
 	
 	nentries = ip->i_size/sizeof(struct d_dirent);
 	
@@ -429,6 +693,10 @@ static off_t dirent_search(struct d_inode *ip, const char *filename,bool create)
 	/* Expand directory. */
 	if (entry < 0)
 	{
+		/* Directory is getting large, so hash it. */
+		if ((ip->i_size == BLOCK_SIZE) && (dindex_build(ip, DINDEX_MIN) > 0))
+			return (dirent_search(ip, filename, create));
+		
 		entry = nentries;
 		blk = minix_block_map(ip, entry*sizeof(struct d_dirent), true);
 		ip->i_size += sizeof(struct d_dirent);